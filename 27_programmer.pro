@@ -0,0 +1,6 @@
+# Core library, GUI and command line programmer
+TEMPLATE = subdirs
+SUBDIRS = core gui cli
+
+gui.depends = core
+cli.depends = core
@@ -0,0 +1,517 @@
+#include "cli.h"
+#include "chipimage.h"
+#include "chipdatabase.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QFileInfo>
+//----------------------------------------------------------------------
+
+Cli::Cli(QObject *parent) :
+    QObject(parent)
+{
+    QObject::connect(&arduino, SIGNAL(LogSignal(QString)), this, SLOT(LogSlot(QString)));
+    QObject::connect(&arduino, SIGNAL(ConnectedSignal(bool, qint32)), this, SLOT(ConnectedSlot(bool, qint32)));
+    QObject::connect(&arduino, SIGNAL(PortErrorSignal(QString)), this, SLOT(PortErrorSlot(QString)));
+    QObject::connect(&arduino, SIGNAL(SerialOperationCompleteSignal()), this, SLOT(SerialOperationCompleteSlot()));
+    QObject::connect(&arduino, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)), this, SLOT(ProgressSlot(quint32, quint32, quint32, qint32)));
+    QObject::connect(&arduino, SIGNAL(ReadCompleteSignal()), this, SLOT(ReadCompleteSlot()));
+    QObject::connect(&arduino, SIGNAL(WriteCompleteSignal()), this, SLOT(WriteCompleteSlot()));
+    QObject::connect(&arduino, SIGNAL(WriteErrorSignal(quint32, QString)), this, SLOT(WriteErrorSlot(quint32, QString)));
+    QObject::connect(&arduino, SIGNAL(BlankCheckSignal(bool, int, int, int)), this, SLOT(BlankCheckSlot(bool, int, int, int)));
+    QObject::connect(&arduino, SIGNAL(VoltageUpdatedSignal(double)), this, SLOT(VoltageSlot(double)));
+    QObject::connect(&arduino, SIGNAL(ErrorSignal(QString)), this, SLOT(ErrorSlot(QString)));
+
+    timeoutTimer.setSingleShot(true);
+    QObject::connect(&timeoutTimer, SIGNAL(timeout()), this, SLOT(TimeoutSlot()));
+}
+//----------------------------------------------------------------------
+
+int Cli::Parse(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Arduino 27CXXX EEPROM programmer, command line interface.\n"
+                                     "Prints one JSON object with the result, exit codes: 0 done, 1 usage,\n"
+                                     "2 programmer not found, 3 operation failed, 4 verify or blank check failed.");
+    QCommandLineOption helpOption = parser.addHelpOption();
+    QCommandLineOption portOption(QStringList() << "p" << "port", "Serial port of the programmer, or model:<file> for a software chip.", "port");
+    QCommandLineOption chipOption(QStringList() << "c" << "chip", "Chip type, 27C16 to 27C080, or a part from the chip database.", "chip");
+    QCommandLineOption chipsOption("chips", "Chip database to load instead of chips.json.", "file");
+    QCommandLineOption baudOption(QStringList() << "b" << "baud", "Baud rate to try first.", "rate");
+    QCommandLineOption timeoutOption("timeout", "Seconds without progress before giving up, 30 by default.", "seconds", "30");
+    QCommandLineOption progressOption("progress", "Print a JSON progress line for every update.");
+    QCommandLineOption verboseOption(QStringList() << "v" << "verbose", "Log the connection on stderr.");
+    parser.addOption(portOption);
+    parser.addOption(chipOption);
+    parser.addOption(chipsOption);
+    parser.addOption(baudOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(progressOption);
+    parser.addOption(verboseOption);
+    parser.addPositionalArgument("command", "read <file>, write <file>, verify <file>, blank, voltage,\n"
+                                            "peek <address>... or poke <address>=<value>...");
+    parser.addPositionalArgument("file", "Chip image, raw binary, or the bytes to peek and poke.", "[file]");
+
+    if(!parser.parse(arguments))
+    {
+        Fail(EXIT_USAGE, parser.errorText());
+        return EXIT_USAGE;
+    }
+    if(parser.isSet(helpOption))
+    {
+        QTextStream(stdout) << parser.helpText();
+        return EXIT_OK;
+    }
+
+    showProgress = parser.isSet(progressOption);
+    verbose = parser.isSet(verboseOption);
+
+    QStringList positional = parser.positionalArguments();
+    commandName = positional.value(0);
+    const QMap<QString, COMMAND> commands = {
+        { "read", READ }, { "write", WRITE }, { "verify", VERIFY }, { "blank", BLANK }, { "voltage", VOLTAGE },
+        { "peek", PEEK }, { "poke", POKE }
+    };
+    if(!commands.contains(commandName))
+    {
+        Fail(EXIT_USAGE, QString("Unknown command \"%1\"").arg(commandName));
+        return EXIT_USAGE;
+    }
+    command = commands.value(commandName);
+
+    portName = parser.value(portOption);
+    if(portName.isEmpty())
+    {
+        Fail(EXIT_USAGE, QString("No serial port given"));
+        return EXIT_USAGE;
+    }
+
+    QString error;
+    ChipDatabase &database = ChipDatabase::Instance();
+    if(!(parser.isSet(chipsOption) ? database.Load(parser.value(chipsOption), error) : database.LoadDefault(error)))
+    {
+        Fail(EXIT_USAGE, error);
+        return EXIT_USAGE;
+    }
+
+    // a part name picks its own timing, a family name the generic part
+    const ChipDatabase::Chip *part = database.Find(parser.value(chipOption));
+    if(part)
+    {
+        chip = part->type;
+        partName = part->name;
+    }
+    else if(command != VOLTAGE && !Arduino::ParseChipType(parser.value(chipOption), chip))
+    {
+        Fail(EXIT_USAGE, QString("Unknown chip \"%1\"").arg(parser.value(chipOption)));
+        return EXIT_USAGE;
+    }
+
+    bool valid = true;
+    int timeout = parser.value(timeoutOption).toInt(&valid);
+    if(!valid || timeout <= 0)
+    {
+        Fail(EXIT_USAGE, QString("Invalid timeout \"%1\"").arg(parser.value(timeoutOption)));
+        return EXIT_USAGE;
+    }
+    timeoutTimer.setInterval(timeout * 1000);
+
+    baudRates = Arduino::BaudRates();
+    if(parser.isSet(baudOption))
+    {
+        qint32 baudRate = parser.value(baudOption).toInt(&valid);
+        if(!valid || baudRate <= 0)
+        {
+            Fail(EXIT_USAGE, QString("Invalid baud rate \"%1\"").arg(parser.value(baudOption)));
+            return EXIT_USAGE;
+        }
+        baudRates = Arduino::BaudRates(baudRate);
+    }
+
+    if(command == READ || command == WRITE || command == VERIFY)
+    {
+        fileName = positional.value(1);
+        if(fileName.isEmpty())
+        {
+            Fail(EXIT_USAGE, QString("No file given"));
+            return EXIT_USAGE;
+        }
+    }
+
+    // images are checked before the programmer is touched, and only read
+    // once it is known whether they can stream
+    if(command == WRITE || command == VERIFY)
+    {
+        QFileInfo info(fileName);
+        if(!info.isFile())
+        {
+            Fail(EXIT_USAGE, QString("%1: no such file").arg(fileName));
+            return EXIT_USAGE;
+        }
+        if(info.size() != Arduino::ChipSize(chip))
+        {
+            Fail(EXIT_USAGE, QString("%1 holds %2 bytes, the chip %3").arg(fileName).arg(info.size()).arg(Arduino::ChipSize(chip)));
+            return EXIT_USAGE;
+        }
+    }
+
+    // addresses and values in C notation, 0x1F00=0xA5 or 7936=165
+    if(command == PEEK || command == POKE)
+    {
+        if(positional.length() < 2)
+        {
+            Fail(EXIT_USAGE, QString("No address given"));
+            return EXIT_USAGE;
+        }
+        for(const QString &argument : positional.mid(1))
+        {
+            QStringList fields = argument.split('=');
+            bool validAddress = false;
+            bool validValue = command == PEEK;
+            int address = fields.value(0).toInt(&validAddress, 0);
+            int value = command == POKE ? fields.value(1).toInt(&validValue, 0) : 0;
+            if(fields.length() != (command == POKE ? 2 : 1) || !validAddress || !validValue
+               || address < 0 || address >= Arduino::ChipSize(chip) || value < 0 || value > 0xFF)
+            {
+                Fail(EXIT_USAGE, QString("Invalid %1 \"%2\"").arg(command == POKE ? "address=value" : "address").arg(argument));
+                return EXIT_USAGE;
+            }
+            bytes.append(qMakePair(address, static_cast<quint8>(value)));
+        }
+    }
+
+    return EXIT_RUN;
+}
+//----------------------------------------------------------------------
+
+void Cli::Start(void)
+{
+    state = CONNECTING;
+    timeoutTimer.start();
+    arduino.Open(portName, baudRates);
+}
+//----------------------------------------------------------------------
+
+void Cli::LogSlot(QString message)
+{
+    if(verbose) {
+        QTextStream(stderr) << message << endl;
+    }
+}
+//----------------------------------------------------------------------
+
+void Cli::ConnectedSlot(bool connected, qint32 baudRate)
+{
+    (void)baudRate;
+    if(state == FINISHED) {
+        return;
+    }
+    if(!connected)
+    {
+        Fail(EXIT_CONNECTION, QString("Programmer not found on %1").arg(portName));
+        return;
+    }
+
+    // Open() leaves a deselect running, the chip is selected after it
+    state = DESELECTING;
+    timeoutTimer.start();
+}
+//----------------------------------------------------------------------
+
+void Cli::PortErrorSlot(QString message)
+{
+    Fail(EXIT_CONNECTION, message);
+}
+//----------------------------------------------------------------------
+
+void Cli::SerialOperationCompleteSlot(void)
+{
+    timeoutTimer.start();
+    if(state == DESELECTING)
+    {
+        state = SELECTING;
+        arduino.SelectChip(chip, partName);
+    }
+    else if(state == SELECTING)
+    {
+        state = RUNNING;
+        RunCommand();
+    }
+}
+//----------------------------------------------------------------------
+
+void Cli::RunCommand(void)
+{
+    switch(command)
+    {
+        case READ:
+            // streamed straight to the file, which is only replaced once complete
+            if(arduino.HasImageStreaming())
+            {
+                readFile.setFileName(fileName);
+                if(!readFile.open(QIODevice::WriteOnly))
+                {
+                    Fail(EXIT_OPERATION, QString("%1: %2").arg(fileName).arg(readFile.errorString()));
+                    return;
+                }
+                arduino.SetImageDevice(&readFile);
+            }
+            arduino.ReadChip();
+            break;
+        case WRITE:
+            if(OpenImage()) {
+                arduino.WriteChip(fileData);
+            }
+            break;
+        case VERIFY:
+            if(OpenImage()) {
+                arduino.VerifyChip(fileData);
+            }
+            break;
+        case BLANK:
+            // older firmware has no on-device scan, the read is checked here
+            if(arduino.HasBlankCheck()) {
+                arduino.BlankCheck(false);
+            }
+            else {
+                arduino.ReadChip();
+            }
+            break;
+        case VOLTAGE:
+            arduino.ReadVoltage();
+            break;
+        case PEEK:
+        case POKE:
+            AccessBytes();
+            break;
+    }
+}
+//----------------------------------------------------------------------
+
+void Cli::AccessBytes(void)
+{
+    // one batch of byte access frames, answered before it returns
+    QByteArray values;
+    bool done;
+    if(command == PEEK)
+    {
+        QVector<int> addresses;
+        for(const QPair<int, quint8> &byte : bytes) {
+            addresses.append(byte.first);
+        }
+        done = arduino.ReadBytes(addresses, values);
+    }
+    else {
+        done = arduino.WriteBytes(bytes, values);
+    }
+    if(!done)
+    {
+        Fail(EXIT_OPERATION, QString("Byte access failed")); // after ErrorSlot when the firmware answered
+        return;
+    }
+
+    QJsonArray addresses;
+    QJsonArray read;
+    for(int i = 0; i < bytes.length(); i++)
+    {
+        addresses.append(bytes[i].first);
+        read.append(static_cast<quint8>(values[i]));
+    }
+    QJsonObject result;
+    result["addresses"] = addresses;
+    result["values"] = read;
+    Finish(EXIT_OK, result);
+}
+//----------------------------------------------------------------------
+
+bool Cli::OpenImage(void)
+{
+    imageFile.setFileName(fileName);
+    if(!imageFile.open(QIODevice::ReadOnly))
+    {
+        Fail(EXIT_OPERATION, QString("%1: %2").arg(fileName).arg(imageFile.errorString()));
+        return false;
+    }
+
+    // older firmware gets the whole image at once
+    if(arduino.HasImageStreaming())
+    {
+        arduino.SetImageDevice(&imageFile);
+        return true;
+    }
+    fileData = imageFile.readAll();
+    imageFile.close();
+    return true;
+}
+//----------------------------------------------------------------------
+
+void Cli::ProgressSlot(quint32 done, quint32 total, quint32 bytesPerSecond, qint32 remaining)
+{
+    timeoutTimer.start();
+    if(!showProgress || state != RUNNING) {
+        return;
+    }
+
+    QJsonObject progress;
+    progress["progress"] = static_cast<double>(done);
+    progress["total"] = static_cast<double>(total);
+    progress["bytes_per_second"] = static_cast<double>(bytesPerSecond);
+    progress["remaining_ms"] = remaining;
+    QTextStream(stdout) << QJsonDocument(progress).toJson(QJsonDocument::Compact) << endl;
+}
+//----------------------------------------------------------------------
+
+void Cli::ReadCompleteSlot(void)
+{
+    if(state != RUNNING) {
+        return;
+    }
+
+    const QByteArray &data = *arduino.GetReadBuffer();
+    QJsonObject result = TransferResult();
+
+    if(command == READ && readFile.isOpen())
+    {
+        arduino.SetImageDevice(nullptr);
+        if(!readFile.commit())
+        {
+            Fail(EXIT_OPERATION, QString("%1: %2").arg(fileName).arg(readFile.errorString()));
+            return;
+        }
+        result["file"] = fileName;
+        Finish(EXIT_OK, result);
+        return;
+    }
+    if(command == READ)
+    {
+        QFile file(fileName);
+        if(!file.open(QIODevice::WriteOnly) || file.write(data) != data.length())
+        {
+            Fail(EXIT_OPERATION, QString("%1: %2").arg(fileName).arg(file.errorString()));
+            return;
+        }
+        result["file"] = fileName;
+        Finish(EXIT_OK, result);
+        return;
+    }
+
+    // the blank check fallback reports like the on-device scan
+    if(command == BLANK)
+    {
+        ChipImage::BlankCheck check = ChipImage::CheckBlank(data);
+        BlankCheckSlot(check.blank, check.firstProgrammed, check.programmedBytes, check.programmedBits);
+        return;
+    }
+
+    // a streamed verify was compared as it came in
+    ChipImage::Comparison comparison = imageFile.isOpen() ? arduino.GetComparison() : ChipImage::Compare(data, fileData);
+    result["errors"] = comparison.errors;
+    result["warnings"] = comparison.warnings;
+    if(comparison.firstMismatch != -1) {
+        result["first_address"] = comparison.firstMismatch;
+    }
+    Finish(comparison.firstMismatch != -1 ? EXIT_CHECK : EXIT_OK, result);
+}
+//----------------------------------------------------------------------
+
+void Cli::WriteCompleteSlot(void)
+{
+    if(state != RUNNING) {
+        return;
+    }
+
+    Arduino::TransferStatistics statistics = arduino.GetTransferStatistics();
+    QJsonObject result = TransferResult();
+    result["programmed_bytes"] = static_cast<double>(statistics.programmedBytes);
+    result["skipped_bytes"] = static_cast<double>(statistics.skippedBytes);
+    Finish(EXIT_OK, result);
+}
+//----------------------------------------------------------------------
+
+void Cli::WriteErrorSlot(quint32 address, QString message)
+{
+    Fail(EXIT_OPERATION, QString("Write error for block 0x%1, %2").arg(address, 0, 16).arg(message));
+}
+//----------------------------------------------------------------------
+
+void Cli::BlankCheckSlot(bool blank, int firstProgrammed, int programmedBytes, int programmedBits)
+{
+    if(state != RUNNING) {
+        return;
+    }
+
+    QJsonObject result;
+    result["blank"] = blank;
+    result["elapsed_ms"] = static_cast<double>(arduino.GetTransferStatistics().elapsed);
+    if(!blank)
+    {
+        result["first_address"] = firstProgrammed;
+        result["programmed_bytes"] = programmedBytes;
+        result["programmed_bits"] = programmedBits;
+    }
+    Finish(blank ? EXIT_OK : EXIT_CHECK, result);
+}
+//----------------------------------------------------------------------
+
+void Cli::VoltageSlot(double value)
+{
+    if(state != RUNNING) {
+        return;
+    }
+
+    QJsonObject result;
+    result["volts"] = value / 100.0;
+    Finish(EXIT_OK, result);
+}
+//----------------------------------------------------------------------
+
+void Cli::ErrorSlot(QString message)
+{
+    Fail(EXIT_OPERATION, message);
+}
+//----------------------------------------------------------------------
+
+void Cli::TimeoutSlot(void)
+{
+    Fail(state == RUNNING ? EXIT_OPERATION : EXIT_CONNECTION, QString("Timed out"));
+}
+//----------------------------------------------------------------------
+
+QJsonObject Cli::TransferResult(void)
+{
+    Arduino::TransferStatistics statistics = arduino.GetTransferStatistics();
+    QJsonObject result;
+    result["bytes"] = static_cast<double>(statistics.dataBytes);
+    result["elapsed_ms"] = static_cast<double>(statistics.elapsed);
+    result["bytes_per_second"] = qRound(statistics.dataBytes * 1000.0 / qMax<qint64>(statistics.elapsed, 1));
+    return result;
+}
+//----------------------------------------------------------------------
+
+void Cli::Finish(EXIT_CODE code, QJsonObject result)
+{
+    if(state == FINISHED) {
+        return;
+    }
+    state = FINISHED;
+    timeoutTimer.stop();
+
+    result["command"] = commandName;
+    result["status"] = code == EXIT_OK ? "ok" : (code == EXIT_CHECK ? "failed" : "error");
+    result["exit_code"] = static_cast<int>(code);
+    QTextStream(stdout) << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+
+    arduino.Close();
+    QCoreApplication::exit(code);
+}
+//----------------------------------------------------------------------
+
+void Cli::Fail(EXIT_CODE code, const QString &message)
+{
+    QJsonObject result;
+    result["message"] = message;
+    Finish(code, result);
+}
+//----------------------------------------------------------------------
@@ -0,0 +1,93 @@
+#ifndef CLI_H
+#define CLI_H
+//----------------------------------------------------------------------
+#include "arduino.h"
+#include <QObject>
+#include <QJsonObject>
+#include <QTimer>
+#include <QFile>
+#include <QSaveFile>
+//----------------------------------------------------------------------
+
+// Runs one chip operation from the command line and reports it as a
+// single JSON object on stdout, the exit code tells scripts how it ended
+class Cli : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum EXIT_CODE {
+        EXIT_OK = 0,
+        EXIT_USAGE = 1,
+        EXIT_CONNECTION = 2,
+        EXIT_OPERATION = 3,
+        EXIT_CHECK = 4, // verify mismatch or chip not blank
+        EXIT_RUN = -1
+    };
+
+    explicit Cli(QObject *parent = nullptr);
+    int Parse(const QStringList &arguments);
+
+public slots:
+    void Start(void);
+
+private slots:
+    void LogSlot(QString);
+    void ConnectedSlot(bool, qint32);
+    void PortErrorSlot(QString);
+    void SerialOperationCompleteSlot(void);
+    void ProgressSlot(quint32, quint32, quint32, qint32);
+    void ReadCompleteSlot(void);
+    void WriteCompleteSlot(void);
+    void WriteErrorSlot(quint32, QString);
+    void BlankCheckSlot(bool, int, int, int);
+    void VoltageSlot(double);
+    void ErrorSlot(QString);
+    void TimeoutSlot(void);
+
+private:
+    enum COMMAND {
+        READ,
+        WRITE,
+        VERIFY,
+        BLANK,
+        VOLTAGE,
+        PEEK,
+        POKE
+    };
+
+    enum STATE {
+        CONNECTING,
+        DESELECTING,
+        SELECTING,
+        RUNNING,
+        FINISHED
+    };
+
+    Arduino arduino;
+    QTimer timeoutTimer;
+    STATE state = CONNECTING;
+    COMMAND command = READ;
+    QString commandName;
+    QString portName;
+    QString fileName;
+    QByteArray fileData; // empty when the image streams through imageFile
+    QFile imageFile;
+    QSaveFile readFile;
+    QVector<QPair<int, quint8>> bytes; // peek and poke, the value only for poke
+    Arduino::CHIP_TYPE chip = Arduino::NONE;
+    QString partName;
+    QList<qint32> baudRates;
+    bool showProgress = false;
+    bool verbose = false;
+
+    void RunCommand(void);
+    bool OpenImage(void);
+    void AccessBytes(void);
+    QJsonObject TransferResult(void);
+    void Finish(EXIT_CODE code, QJsonObject result = QJsonObject());
+    void Fail(EXIT_CODE code, const QString &message);
+};
+//----------------------------------------------------------------------
+
+#endif // CLI_H
@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Headless programmer on the same protocol code as the GUI
+#
+#-------------------------------------------------
+
+QT       += core
+QT       += serialport
+QT       -= gui
+
+TARGET = 27_programmer_cli
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+        main.cpp \
+    cli.cpp
+
+HEADERS += \
+    cli.h
+
+include(../core/core.pri)
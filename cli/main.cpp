@@ -0,0 +1,19 @@
+#include "cli.h"
+#include <QCoreApplication>
+#include <QTimer>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setOrganizationName("arduino_eprom27_programmer");
+    a.setApplicationName("27_programmer_cli");
+
+    Cli cli;
+    int exitCode = cli.Parse(a.arguments());
+    if(exitCode != Cli::EXIT_RUN) {
+        return exitCode;
+    }
+
+    QTimer::singleShot(0, &cli, SLOT(Start()));
+    return a.exec();
+}
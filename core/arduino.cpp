@@ -0,0 +1,2041 @@
+#include "arduino.h"
+#include "chipdatabase.h"
+#include "eprommodel.h"
+#include <QDebug>
+#include <QThread>
+#include <QMap>
+#include <QSettings>
+#include <QSerialPortInfo>
+
+//----------------------------------------------------------------------
+
+Arduino::Arduino(QObject *parent) :
+    QObject(parent),
+    serialPort(new QSerialPort(this)),
+    legacyTimer(new QTimer(this)),
+    abortTimer(new QTimer(this)),
+    frameTimer(new QTimer(this))
+{
+    port = serialPort;
+    legacyTimer->setSingleShot(true);
+    QObject::connect(legacyTimer, SIGNAL(timeout()), this, SLOT(LegacyWriteTimeoutSlot()));
+    abortTimer->setSingleShot(true);
+    QObject::connect(abortTimer, SIGNAL(timeout()), this, SLOT(AbortTimeoutSlot()));
+    QObject::connect(this, SIGNAL(SerialOperationCompleteSignal()), abortTimer, SLOT(stop()));
+    frameTimer->setSingleShot(true);
+    QObject::connect(frameTimer, SIGNAL(timeout()), this, SLOT(FrameTimeoutSlot()));
+    QObject::connect(this, SIGNAL(SerialOperationCompleteSignal()), frameTimer, SLOT(stop()));
+
+    // arguments of the signals and slots queued between the GUI and I/O threads
+    qRegisterMetaType<Arduino::CHIP_TYPE>("Arduino::CHIP_TYPE");
+    qRegisterMetaType<QList<qint32>>("QList<qint32>");
+    ResetVariables();
+}
+//----------------------------------------------------------------------
+
+void Arduino::Open(QString path, QList<qint32> baudRates)
+{
+    // a software chip in place of the programmer, everything else is the same
+    if(path.startsWith(MODEL_PORT_PREFIX))
+    {
+        model = new EpromModel(path.mid(path.indexOf(':') + 1), this);
+        port = model;
+    }
+    else
+    {
+        serialPort->setPortName(path);
+        serialPort->setBaudRate(QSerialPort::Baud115200);
+    }
+
+    if(!port->open(QIODevice::ReadWrite))
+    {
+        emit PortErrorSignal(port->errorString());
+        emit ConnectedSignal(false, 0);
+        Close();
+        return;
+    }
+
+    QByteArray readData = port->readAll();
+    while(readData.indexOf(PROGRAMMER_NAME, 0) != -1 || port->waitForReadyRead(5000))
+    {
+        readData.append(port->readAll());
+        if(readData.indexOf(PROGRAMMER_NAME, 0) == -1) {
+            continue;
+        }
+
+        emit LogSignal(QString("Connect successful"));
+        qint32 baudRate = model ? 0 : NegotiateBaudRate(baudRates);
+
+        if(DetectFrameProtocol())
+        {
+            emit LogSignal(QString("Binary protocol v%1").arg(GetProtocolVersion()));
+            if(SetCompression(true)) {
+                emit LogSignal(QString("RLE compression enabled"));
+            }
+            if(SetWideAddresses(true)) {
+                emit LogSignal(QString("32-bit addresses"));
+            }
+            if(SetBlockLength(GetMaxBlockLength())) {
+                emit LogSignal(QString("Block size %1 bytes").arg(GetBlockLength()));
+            }
+        }
+        else {
+            emit LogSignal(QString("Legacy protocol"));
+        }
+
+        SelectChip(NONE);
+        emit ConnectedSignal(true, baudRate);
+        return;
+    }
+
+    emit LogSignal(QString("Arduino programmer not found."));
+    emit ConnectedSignal(false, 0);
+}
+//----------------------------------------------------------------------
+
+void Arduino::Close(void)
+{
+    QObject::disconnect(serialDataConnection);
+    legacyTimer->stop();
+    legacyWriting = false;
+    abortTimer->stop();
+    frameTimer->stop();
+    if(port->isOpen()) {
+        port->close();
+    }
+    if(model)
+    {
+        model->deleteLater();
+        model = nullptr;
+        port = serialPort;
+    }
+}
+//----------------------------------------------------------------------
+
+qint32 Arduino::NegotiateBaudRate(const QList<qint32> &baudRates)
+{
+    for(qint32 baudRate : baudRates)
+    {
+        if(SetBaudRate(baudRate))
+        {
+            emit LogSignal(QString("Baud rate set to %1").arg(baudRate));
+            return baudRate;
+        }
+    }
+
+    emit LogSignal(QString("Baud rate negotiation failed, using %1").arg(serialPort->baudRate()));
+    return 0;
+}
+//----------------------------------------------------------------------
+
+int Arduino::ChipSize(CHIP_TYPE type)
+{
+    const ChipDatabase::Chip *chip = ChipDatabase::Instance().Find(type);
+    return chip ? chip->size : 0;
+}
+//----------------------------------------------------------------------
+
+QList<qint32> Arduino::BaudRates(qint32 first)
+{
+    QList<qint32> baudRates = { 2000000, 1000000, 500000, 250000 };
+    if(first > 0)
+    {
+        baudRates.removeAll(first);
+        baudRates.prepend(first);
+    }
+    return baudRates;
+}
+//----------------------------------------------------------------------
+
+qint32 Arduino::SavedBaudRate(const QString &path)
+{
+    QSettings settings;
+    return settings.value(QString("baudRate/%1").arg(QSerialPortInfo(path).portName()), 0).toInt();
+}
+//----------------------------------------------------------------------
+
+void Arduino::SaveBaudRate(const QString &path, qint32 baudRate)
+{
+    // 0 when the port stayed at the default rate
+    QSettings settings;
+    QString key = QString("baudRate/%1").arg(QSerialPortInfo(path).portName());
+    if(baudRate) {
+        settings.setValue(key, baudRate);
+    }
+    else {
+        settings.remove(key);
+    }
+}
+//----------------------------------------------------------------------
+
+bool Arduino::ParseChipType(const QString &name, CHIP_TYPE &type)
+{
+    const QMap<QString, CHIP_TYPE> chips = {
+        { "C16", C16 }, { "C32", C32 }, { "C64", C64 },
+        { "C128", C128 }, { "C256", C256 }, { "C512", C512 },
+        { "C010", C010 }, { "C020", C020 }, { "C040", C040 }, { "C080", C080 }
+    };
+
+    // 27C256, C256 and 256 all name the same chip, as do 27C010 and 010
+    QString key = name.toUpper();
+    if(key.startsWith("27")) {
+        key.remove(0, 2);
+    }
+    if(!key.startsWith("C")) {
+        key.prepend("C");
+    }
+    if(!chips.contains(key)) {
+        return false;
+    }
+    type = chips.value(key);
+    return true;
+}
+//----------------------------------------------------------------------
+
+void Arduino::ResetVariables(void)
+{
+    maxBufferSize = 0;
+    readBuffer.clear();
+    writeBuffer.clear();
+}
+//----------------------------------------------------------------------
+
+int Arduino::GetChipSize(void)
+{
+    return maxBufferSize;
+}
+//----------------------------------------------------------------------
+
+QByteArray *Arduino::GetReadBuffer(void)
+{
+    return &readBuffer;
+}
+//----------------------------------------------------------------------
+
+void Arduino::Send(const QByteArray &data)
+{
+    emit SerialOperationStartSignal();
+    port->write(data);
+}
+//----------------------------------------------------------------------
+
+void Arduino::ClearPort(void)
+{
+    if(model) {
+        model->Clear();
+    }
+    else {
+        serialPort->clear();
+    }
+}
+//----------------------------------------------------------------------
+
+void Arduino::StartTransfer(int total)
+{
+    transferStatistics = { 0, 0, 0, 0, 0 };
+    transferTimer.start();
+    aborting = false;
+
+    progressTotal = static_cast<quint32>(total);
+    progressDone = 0;
+    progressReported = 0;
+    progressTime = 0;
+    progressRate = 0;
+}
+//----------------------------------------------------------------------
+
+void Arduino::ReportProgress(int done)
+{
+    progressDone = static_cast<quint32>(done);
+    qint64 now = transferTimer.elapsed();
+    if(now - progressTime < PROGRESS_INTERVAL) {
+        return;
+    }
+
+    // smoothed over the last few updates, a verify that starts reading
+    // back after its checksum pass starts over
+    if(progressDone < progressReported) {
+        progressRate = 0;
+    }
+    else if(now > progressTime)
+    {
+        double rate = (progressDone - progressReported) * 1000.0 / (now - progressTime);
+        progressRate = progressRate > 0 ? progressRate * 0.75 + rate * 0.25 : rate;
+    }
+    progressReported = progressDone;
+    progressTime = now;
+
+    qint32 remaining = -1;
+    if(progressRate > 0 && progressTotal >= progressDone) {
+        remaining = static_cast<qint32>(qMin<double>((progressTotal - progressDone) * 1000.0 / progressRate, 0x7FFFFFFF));
+    }
+    emit ProgressSignal(progressDone, progressTotal, static_cast<quint32>(qRound(progressRate)), remaining);
+}
+//----------------------------------------------------------------------
+
+void Arduino::FinishTransfer(void)
+{
+    transferStatistics.elapsed = transferTimer.elapsed();
+
+    // the last update shows the average rate over the whole operation
+    if(progressTotal)
+    {
+        double rate = progressDone * 1000.0 / qMax<qint64>(transferStatistics.elapsed, 1);
+        emit ProgressSignal(progressDone, progressTotal, static_cast<quint32>(qRound(rate)), 0);
+    }
+}
+//----------------------------------------------------------------------
+
+Arduino::TransferStatistics Arduino::GetTransferStatistics(void)
+{
+    return transferStatistics;
+}
+//----------------------------------------------------------------------
+
+void Arduino::ReadChip(void)
+{
+    readBuffer.clear();
+    StartTransfer(maxBufferSize);
+    if(frameProtocol)
+    {
+        readLength = maxBufferSize;
+        readReceived = 0;
+        imageStreaming = imageDevice && HasImageStreaming();
+        if(!imageStreaming) {
+            readBuffer.reserve(maxBufferSize);
+        }
+        frameBuffer.clear();
+        frameWriting = false;
+        frameTimer->start(FRAME_RESPONSE_TIMEOUT);
+        serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(ReadChipFrameSlot()));
+        Send(BuildFrame(FRAME_READ));
+        return;
+    }
+
+    // the image is parsed straight into a buffer of the chip's size
+    readBuffer.resize(maxBufferSize);
+    streamParser.Start(QByteArray(RESPONSE_READ_CHIP).append("\r\n"), readBuffer.data(), maxBufferSize,
+                       QByteArray(RESPONSE_OK).append("\r\n"));
+    serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(ReadChipSlot()));
+    Send(MESSAGE_READ_CHIP);
+}
+//----------------------------------------------------------------------
+
+void Arduino::ReadChipBlocks(int blockLength)
+{
+    if(!SetBlockLength(blockLength))
+    {
+        emit ErrorSignal(QString("Can't set %1 bytes blocks").arg(blockLength));
+        return;
+    }
+    ReadChip();
+}
+//----------------------------------------------------------------------
+
+bool Arduino::ReadRange(int start, int length)
+{
+    if(!frameProtocol || protocolVersion < RANGE_READ_VERSION || start < 0 || length <= 0 || start + length > maxBufferSize)
+    {
+        emit ErrorSignal(QString("Range reads need the binary protocol"));
+        return false;
+    }
+
+    readBuffer.clear();
+    readLength = length;
+    readReceived = 0;
+    imageStreaming = imageDevice && HasImageStreaming();
+    if(!imageStreaming) {
+        readBuffer.reserve(length);
+    }
+    StartTransfer(length);
+    frameBuffer.clear();
+    frameWriting = false;
+    frameTimer->start(FRAME_RESPONSE_TIMEOUT);
+    serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(ReadChipFrameSlot()));
+    Send(BuildFrame(FRAME_READ, RangePayload(start, start + length - 1)));
+    return true;
+}
+//----------------------------------------------------------------------
+
+void Arduino::ReadChipSlot(void)
+{
+    int received = streamParser.GetPayloadReceived();
+    int space;
+    char *destination;
+    while((destination = streamParser.WritePointer(space)) != nullptr && space > 0)
+    {
+        qint64 length = port->read(destination, space);
+        if(length <= 0) {
+            break;
+        }
+        transferStatistics.wireBytes += length;
+        streamParser.Commit(static_cast<int>(length));
+    }
+    if(streamParser.GetPayloadReceived() != received) {
+        ReportProgress(streamParser.GetPayloadReceived());
+    }
+
+    if(streamParser.GetState() == StreamParser::DONE)
+    {
+        transferStatistics.dataBytes = readBuffer.length();
+        FinishTransfer();
+        QObject::disconnect(serialDataConnection);
+        emit ReadCompleteSignal();
+        emit SerialOperationCompleteSignal();
+    }
+}
+//----------------------------------------------------------------------
+
+void Arduino::WriteChip(QByteArray data)
+{
+    SetImage(data);
+    if(ImageLength() != maxBufferSize)
+    {
+        QString errorMessage = "Invalid data length of ";
+        errorMessage.append(QString::number(ImageLength()));
+        emit WriteErrorSignal(0, errorMessage);
+        return;
+    }
+
+    writeRanges = WriteRanges();
+    StartTransfer(frameProtocol ? RangesLength(writeRanges) : maxBufferSize);
+    if(frameProtocol)
+    {
+        writtenBytes = 0;
+        if(writeRanges.isEmpty())
+        {
+            emit WriteCompleteSignal();
+            return;
+        }
+
+        frameBuffer.clear();
+        serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(WriteChipFrameSlot()));
+        emit SerialOperationStartSignal();
+        RequestWriteRange();
+        frameWriting = true;
+        frameTimer->start(WriteFrameTimeout());
+        return;
+    }
+
+    legacyData.clear();
+    legacyBlock = 0;
+    legacyWriting = true;
+    legacyStarted = false;
+    legacyAcknowledging = false;
+    serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(WriteChipSlot()));
+    legacyTimer->start(LEGACY_RESPONSE_TIMEOUT);
+    Send(MESSAGE_WRITE_CHIP);
+}
+//----------------------------------------------------------------------
+
+bool Arduino::WriteRange(int start, QByteArray data)
+{
+    if(!frameProtocol || protocolVersion < SPARSE_WRITE_VERSION || start < 0 || data.isEmpty() || start + data.length() > maxBufferSize)
+    {
+        emit ErrorSignal(QString("Range writes need the binary protocol v%1").arg(SPARSE_WRITE_VERSION));
+        return false;
+    }
+
+    // blocks are taken by chip address, only the range itself is held
+    imageStreaming = false;
+    writeBuffer = data;
+    imageOffset = start;
+    writeRanges.clear();
+    writeRanges.append(qMakePair(start, start + data.length() - 1));
+    writtenBytes = 0;
+
+    StartTransfer(data.length());
+    frameBuffer.clear();
+    serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(WriteChipFrameSlot()));
+    emit SerialOperationStartSignal();
+    RequestWriteRange();
+    frameWriting = true;
+    frameTimer->start(WriteFrameTimeout());
+    return true;
+}
+//----------------------------------------------------------------------
+
+int Arduino::GetWriteLength(const QByteArray &data) const
+{
+    // called from the GUI thread, only the connection's settings are read
+    if(!frameProtocol || protocolVersion < SPARSE_WRITE_VERSION) {
+        return maxBufferSize;
+    }
+
+    QList<QPair<int, int>> ranges;
+    AppendWriteRanges(ranges, data, 0, frameBlockLength);
+    return RangesLength(ranges);
+}
+//----------------------------------------------------------------------
+
+int Arduino::RangesLength(const QList<QPair<int, int>> &ranges)
+{
+    int length = 0;
+    for(const QPair<int, int> &range : ranges) {
+        length += range.second - range.first + 1;
+    }
+    return length;
+}
+//----------------------------------------------------------------------
+
+void Arduino::AppendWriteRanges(QList<QPair<int, int>> &ranges, const QByteArray &data, int address, int blockLength)
+{
+    // blocks holding only 0xFF are left as they are on the chip
+    for(int offset = 0; offset < data.length(); offset += blockLength)
+    {
+        int start = address + offset;
+        int length = qMin(blockLength, data.length() - offset);
+        if(data.mid(offset, length).count(static_cast<char>(0xFF)) == length) {
+            continue;
+        }
+
+        if(!ranges.isEmpty() && ranges.last().second == start - 1) {
+            ranges.last().second = start + length - 1;
+        }
+        else {
+            ranges.append(qMakePair(start, start + length - 1));
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+QList<QPair<int, int>> Arduino::WriteRanges(void)
+{
+    QList<QPair<int, int>> ranges;
+    if(protocolVersion < SPARSE_WRITE_VERSION)
+    {
+        ranges.append(qMakePair(0, maxBufferSize - 1));
+        return ranges;
+    }
+
+    // a streamed image is read a few hundred blocks at a time
+    int imageLength = ImageLength();
+    int chunkLength = frameBlockLength * IMAGE_SCAN_BLOCKS;
+    for(int chunkStart = 0; chunkStart < imageLength; chunkStart += chunkLength) {
+        AppendWriteRanges(ranges, ImageData(chunkStart, qMin(chunkLength, imageLength - chunkStart)), chunkStart, frameBlockLength);
+    }
+    return ranges;
+}
+//----------------------------------------------------------------------
+
+void Arduino::SetImageDevice(QIODevice *device)
+{
+    imageDevice = device;
+}
+//----------------------------------------------------------------------
+
+bool Arduino::HasImageStreaming(void)
+{
+    // reads arrive in order, verify and write take blocks by address
+    return frameProtocol && protocolVersion >= CRC_VERIFY_VERSION;
+}
+//----------------------------------------------------------------------
+
+ChipImage::Comparison Arduino::GetComparison(void)
+{
+    return verifyComparison;
+}
+//----------------------------------------------------------------------
+
+void Arduino::SetImage(const QByteArray &data)
+{
+    imageStreaming = data.isEmpty() && imageDevice && HasImageStreaming();
+    imageOffset = 0;
+    writeBuffer.clear();
+    if(!imageStreaming) {
+        writeBuffer.append(data);
+    }
+}
+//----------------------------------------------------------------------
+
+int Arduino::ImageLength(void)
+{
+    return imageStreaming ? static_cast<int>(qMin<qint64>(imageDevice->size(), 0x7FFFFFFF)) : writeBuffer.length();
+}
+//----------------------------------------------------------------------
+
+QByteArray Arduino::ImageData(int address, int length)
+{
+    if(!imageStreaming) {
+        return writeBuffer.mid(address - imageOffset, length);
+    }
+    if(!imageDevice->seek(address)) {
+        return QByteArray();
+    }
+    return imageDevice->read(length);
+}
+//----------------------------------------------------------------------
+
+bool Arduino::StoreReadData(const QByteArray &data)
+{
+    if(!imageStreaming) {
+        readBuffer.append(data);
+    }
+    else if(imageDevice->write(data) != data.length()) {
+        return false;
+    }
+    readReceived += data.length();
+    ReportProgress(readReceived);
+    return true;
+}
+//----------------------------------------------------------------------
+
+int Arduino::AddressLength(void)
+{
+    return wideAddresses ? 4 : 2;
+}
+//----------------------------------------------------------------------
+
+QByteArray Arduino::AddressBytes(int address)
+{
+    QByteArray bytes;
+    for(int i = 0; i < AddressLength(); i++) {
+        bytes.append(static_cast<char>((address >> (i * 8)) & 0xFF));
+    }
+    return bytes;
+}
+//----------------------------------------------------------------------
+
+int Arduino::AddressAt(const QByteArray &payload, int offset)
+{
+    if(payload.length() < offset + AddressLength()) {
+        return -1;
+    }
+
+    int address = 0;
+    for(int i = AddressLength() - 1; i >= 0; i--) {
+        address = (address << 8) | static_cast<quint8>(payload[offset + i]);
+    }
+    return address;
+}
+//----------------------------------------------------------------------
+
+QByteArray Arduino::RangePayload(int first, int last)
+{
+    return AddressBytes(first).append(AddressBytes(last));
+}
+//----------------------------------------------------------------------
+
+void Arduino::RequestWriteRange(void)
+{
+    const QPair<int, int> &range = writeRanges.first();
+    writeAddress = range.first;
+    sendAddress = range.first;
+    writeInFlight = 0;
+    writeCredits = 0;
+    pulseInfoPending = false;
+
+    // older firmware always writes the whole chip
+    if(protocolVersion < SPARSE_WRITE_VERSION) {
+        port->write(BuildFrame(FRAME_WRITE));
+    }
+    else {
+        port->write(BuildFrame(FRAME_WRITE, RangePayload(range.first, range.second)));
+    }
+}
+//----------------------------------------------------------------------
+
+int Arduino::SendWriteBlock(int address)
+{
+    QByteArray block = ImageData(address, qMin(frameBlockLength, writeRanges.first().second + 1 - address));
+    QByteArray frameData;
+    if(compression)
+    {
+        QByteArray encoded = RleEncode(block);
+        if(encoded.length() < block.length()) {
+            frameData = BuildFrame(FRAME_DATA_RLE, encoded);
+        }
+    }
+    if(frameData.isEmpty()) {
+        frameData = BuildFrame(FRAME_DATA, block);
+    }
+    port->write(frameData);
+    transferStatistics.wireBytes += frameData.length();
+    transferStatistics.dataBytes += block.length();
+    return block.length();
+}
+//----------------------------------------------------------------------
+
+void Arduino::FillWriteWindow(void)
+{
+    // stream ahead as far as the firmware has buffers, each OK returns one
+    while(!aborting && writeInFlight < writeCredits && sendAddress <= writeRanges.first().second)
+    {
+        sendAddress += SendWriteBlock(sendAddress);
+        writeInFlight++;
+    }
+}
+//----------------------------------------------------------------------
+
+bool Arduino::NextWriteRange(void)
+{
+    writeRanges.removeFirst();
+    if(!writeRanges.isEmpty() && aborting)
+    {
+        // an ABORT between two ranges found nothing running
+        QObject::disconnect(serialDataConnection);
+        emit WriteErrorSignal(static_cast<quint32>(writeRanges.first().first), QString("Aborted"));
+        emit SerialOperationCompleteSignal();
+        return true;
+    }
+    if(!writeRanges.isEmpty())
+    {
+        RequestWriteRange();
+        return false;
+    }
+
+    FinishTransfer();
+    QObject::disconnect(serialDataConnection);
+    emit WriteCompleteSignal();
+    emit SerialOperationCompleteSignal();
+    return true;
+}
+//----------------------------------------------------------------------
+
+void Arduino::WriteChipSlot(void)
+{
+    legacyData.append(port->readAll());
+
+    // an error ends the write wherever it comes, once its line is complete
+    int index = legacyData.indexOf(RESPONSE_ERROR);
+    if(index != -1)
+    {
+        int end = legacyData.indexOf("\r\n", index);
+        if(end != -1) {
+            EndLegacyWrite(QString(legacyData.mid(index + 8, end - index - 8)).trimmed());
+        }
+        return;
+    }
+
+    // the command is acknowledged, then WRIT once the voltage is checked
+    if(!legacyStarted)
+    {
+        index = legacyData.indexOf(QByteArray(RESPONSE_WRITE_CHIP).append("\r\n"));
+        if(index == -1) {
+            return;
+        }
+        legacyData.remove(0, index + 10);
+        legacyStarted = true;
+    }
+
+    while(true)
+    {
+        if(legacyAcknowledging)
+        {
+            index = legacyData.indexOf(QByteArray(RESPONSE_OK).append("\r\n"));
+            if(index == -1) {
+                break;
+            }
+            legacyData.remove(0, index + 10);
+            legacyAcknowledging = false;
+            legacyBlock += LEGACY_BLOCK_LEN;
+            ReportProgress(legacyBlock);
+            if(legacyBlock >= maxBufferSize)
+            {
+                EndLegacyWrite();
+                return;
+            }
+        }
+
+        // BLCK and the block address in decimal
+        index = legacyData.indexOf(RESPONSE_BLOCK_REQUEST);
+        int end = index != -1 ? legacyData.indexOf("\r\n", index) : -1;
+        if(end == -1) {
+            break;
+        }
+        int blockIndex = QString(legacyData.mid(index + 8, end - index - 8)).simplified().toInt();
+        legacyData.remove(0, end + 2);
+        if(blockIndex != legacyBlock)
+        {
+            EndLegacyWrite(QString("Invalid block %1 received, expected %2").arg(blockIndex, 0, 16).arg(legacyBlock, 0, 16));
+            return;
+        }
+
+        port->write(writeBuffer.constData() + legacyBlock, LEGACY_BLOCK_LEN);
+        transferStatistics.wireBytes += LEGACY_BLOCK_LEN;
+        transferStatistics.dataBytes += LEGACY_BLOCK_LEN;
+        legacyAcknowledging = true;
+    }
+
+    // programming a block takes up to blockTimeout, the rest answers at once
+    legacyTimer->start(legacyAcknowledging ? blockTimeout + 250 : LEGACY_RESPONSE_TIMEOUT);
+}
+//----------------------------------------------------------------------
+
+void Arduino::LegacyWriteTimeoutSlot(void)
+{
+    if(!legacyWriting) {
+        return;
+    }
+    if(legacyAcknowledging) {
+        EndLegacyWrite(QString("Can't acknowledge block %1").arg(legacyBlock, 0, 16));
+    }
+    else {
+        EndLegacyWrite(QString("Invalid acknowledge data received"));
+    }
+}
+//----------------------------------------------------------------------
+
+void Arduino::EndLegacyWrite(const QString &error)
+{
+    legacyTimer->stop();
+    legacyWriting = false;
+    QObject::disconnect(serialDataConnection);
+
+    if(error.isEmpty())
+    {
+        FinishTransfer();
+        emit WriteCompleteSignal();
+    }
+    else {
+        emit WriteErrorSignal(static_cast<quint32>(legacyBlock), error);
+    }
+    emit SerialOperationCompleteSignal();
+}
+//----------------------------------------------------------------------
+
+void Arduino::SelectChip(Arduino::CHIP_TYPE type, QString part)
+{
+    // A16 and up go out on the third shift register, only wide frames carry them
+    if(type > C512 && !wideAddresses)
+    {
+        const ChipDatabase::Chip *family = ChipDatabase::Instance().Find(type);
+        emit ErrorSignal(QString("%1 needs firmware with the third address stage").arg(family ? family->name : QString("Chip")));
+        type = NONE;
+    }
+
+    // a part of another family falls back to the family's generic part
+    const ChipDatabase::Chip *chip = ChipDatabase::Instance().Find(part);
+    if(!chip || chip->type != type) {
+        chip = ChipDatabase::Instance().Find(type);
+    }
+
+    maxBufferSize = ChipSize(type);
+    blockTimeout = chip ? chip->blockTimeout : 100;
+    timingPayload.clear();
+    if(frameProtocol)
+    {
+        selectedChipType = type;
+
+        // older firmware keeps its built-in timing
+        if(chip && protocolVersion >= TIMING_VERSION)
+        {
+            timingPayload.append(static_cast<char>(chip->pulseWidth & 0xFF));
+            timingPayload.append(static_cast<char>(chip->pulseWidth >> 8));
+            timingPayload.append(static_cast<char>(chip->maxPulses));
+            timingPayload.append(static_cast<char>(chip->overprogramFactor));
+            timingPayload.append(static_cast<char>(chip->vppLine));
+            emit LogSignal(QString("%1: %2 us pulses, up to %3, overprogram x%4")
+                           .arg(chip->name).arg(chip->pulseWidth).arg(chip->maxPulses).arg(chip->overprogramFactor));
+        }
+
+        frameBuffer.clear();
+        serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(SelectChipFrameSlot()));
+        Send(BuildFrame(FRAME_SELECT, QByteArray(1, static_cast<char>(type))));
+        return;
+    }
+
+    serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(SelectChipSlot()));
+
+    switch(type)
+    {
+        case C16:
+            Send(MESSAGE_SELECT_C16);
+            break;
+        case C32:
+            Send(MESSAGE_SELECT_C32);
+            break;
+        case C64:
+            Send(MESSAGE_SELECT_C64);
+            break;
+        case C128:
+            Send(MESSAGE_SELECT_C128);
+            break;
+        case C256:
+            Send(MESSAGE_SELECT_C256);
+            break;
+        case C512:
+            Send(MESSAGE_SELECT_C512);
+            break;
+        default:
+            Send(MESSAGE_SELECT_NONE);
+    }
+
+    selectedChipType = type;
+}
+//----------------------------------------------------------------------
+
+void Arduino::SelectChipSlot(void)
+{
+    while(!port->atEnd())
+    {
+        QByteArray readData = port->readAll();
+        if(readData.indexOf(RESPONSE_OK, 0) != -1)
+        {
+            QObject::disconnect(serialDataConnection);
+            emit SerialOperationCompleteSignal();
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+void Arduino::ReadVoltage(void)
+{
+    if(frameProtocol)
+    {
+        frameBuffer.clear();
+        serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(ReadVoltageFrameSlot()));
+        Send(BuildFrame(FRAME_VOLTAGE));
+        return;
+    }
+
+    serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(ReadVoltageSlot()));
+    Send(MESSAGE_VOLTAGE_INFO);
+}
+//----------------------------------------------------------------------
+
+void Arduino::ReadVoltageSlot(void)
+{
+    while(!port->atEnd())
+    {
+        QByteArray readData = port->readAll();
+
+        QString str = RESPONSE_OK;
+        str.append("\r\n");
+
+        int index = 0;
+        if((index = readData.indexOf(str, 0)) != -1)
+        {
+            readData.remove(0, index + str.length());
+            str = RESPONSE_VOLTAGEINFO;
+            if((index = readData.indexOf(str, 0)) != -1)
+            {
+                readData.remove(0, index + str.length());
+                QObject::disconnect(serialDataConnection);
+                emit VoltageUpdatedSignal(QString(readData).simplified().toDouble() * 100);
+                emit SerialOperationCompleteSignal();
+            }
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+bool Arduino::HasBlankCheck(void)
+{
+    return frameProtocol && protocolVersion >= BLANK_CHECK_VERSION;
+}
+//----------------------------------------------------------------------
+
+bool Arduino::HasCrcVerify(void)
+{
+    // only blocks whose checksum differs are read back
+    return frameProtocol && protocolVersion >= CRC_VERIFY_VERSION;
+}
+//----------------------------------------------------------------------
+
+void Arduino::BlankCheck(bool earlyExit)
+{
+    StartTransfer();
+    frameBuffer.clear();
+    // the answer only comes once the whole chip is scanned
+    frameWriting = false;
+    frameTimer->start(ScanFrameTimeout(maxBufferSize));
+    serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(BlankCheckFrameSlot()));
+    Send(BuildFrame(FRAME_BLANK, QByteArray(1, earlyExit ? 1 : 0)));
+}
+//----------------------------------------------------------------------
+
+void Arduino::VerifyChip(QByteArray data)
+{
+    // older firmware can't checksum, compare the full dump instead
+    if(!HasCrcVerify() || (!data.isEmpty() && data.length() != maxBufferSize))
+    {
+        ReadChip();
+        return;
+    }
+    if(data.isEmpty() && (!imageDevice || imageDevice->size() != maxBufferSize))
+    {
+        emit ErrorSignal(QString("Image doesn't match the chip size"));
+        return;
+    }
+
+    // unchanged blocks are taken from the expected data, differing ones are read
+    // back, or only counted against a streamed image
+    SetImage(data);
+    readBuffer = data;
+    verifyComparison = { 0, 0, -1, QByteArray() };
+    crcTable.clear();
+    verifyRanges.clear();
+    verifyReading = false;
+
+    StartTransfer(maxBufferSize);
+    frameBuffer.clear();
+    // a table frame is sent for every buffer full of checksums
+    frameWriting = false;
+    frameTimer->start(ScanFrameTimeout(qMin(maxBufferSize, (maxBlockLength / 4) << VERIFY_BLOCK_SHIFT)));
+    serialDataConnection = QObject::connect(port, SIGNAL(readyRead()), this, SLOT(VerifyChipFrameSlot()));
+    Send(BuildFrame(FRAME_CRC, QByteArray(1, static_cast<char>(VERIFY_BLOCK_SHIFT))));
+}
+//----------------------------------------------------------------------
+
+void Arduino::Abort(void)
+{
+    if(!serialDataConnection) {
+        return;
+    }
+
+    // the running operation's slot gets ERROR_ABORTED like any other error
+    if(frameProtocol && protocolVersion >= ABORT_VERSION)
+    {
+        aborting = true;
+        port->write(BuildFrame(FRAME_ABORT));
+        abortTimer->start(ABORT_DELAY + blockTimeout + ABORT_TIMEOUT);
+        return;
+    }
+
+    // older firmware runs the operation to its end, only stop listening to it.
+    // A legacy write is stopped by sending no more blocks, an ABRT in place of
+    // one would be programmed; the firmware gives up on it after its timeout
+    QObject::disconnect(serialDataConnection);
+    int delay = ABORT_DELAY;
+    if(legacyWriting)
+    {
+        legacyTimer->stop();
+        legacyWriting = false;
+        delay += blockTimeout + LEGACY_SERIAL_TIMEOUT;
+    }
+    else if(!frameProtocol) {
+        port->write(QByteArray(MESSAGE_ABORT).leftJustified(16, ' '));
+    }
+    QTimer::singleShot(delay, this, SLOT(AbortCompleteSlot()));
+}
+//----------------------------------------------------------------------
+
+void Arduino::AbortCompleteSlot(void)
+{
+    ClearPort();
+    emit ErrorSignal(QString("Aborted"));
+    emit SerialOperationCompleteSignal();
+}
+//----------------------------------------------------------------------
+
+int Arduino::WriteFrameTimeout(void)
+{
+    // blockTimeout is given per legacy block, every block in flight may be
+    // programmed before the next answer
+    int blockTime = blockTimeout * ((frameBlockLength + LEGACY_BLOCK_LEN - 1) / LEGACY_BLOCK_LEN);
+    return blockTime * qMax(writeInFlight, 1) + FRAME_RESPONSE_TIMEOUT;
+}
+//----------------------------------------------------------------------
+
+int Arduino::ScanFrameTimeout(int length)
+{
+    return FRAME_RESPONSE_TIMEOUT + (length + 1023) / 1024 * SCAN_TIMEOUT_PER_KB;
+}
+//----------------------------------------------------------------------
+
+void Arduino::FrameTimeoutSlot(void)
+{
+    QString message = QString("No answer from the programmer");
+    if(!frameWriting)
+    {
+        FrameOperationError(message);
+        return;
+    }
+    QObject::disconnect(serialDataConnection);
+    emit WriteErrorSignal(static_cast<quint32>(writeAddress), message);
+    emit SerialOperationCompleteSignal();
+}
+//----------------------------------------------------------------------
+
+void Arduino::AbortTimeoutSlot(void)
+{
+    // the firmware was reset or lost the frame, the operation ends here
+    emit LogSignal(QString("Abort not answered"));
+    QObject::disconnect(serialDataConnection);
+    AbortCompleteSlot();
+}
+//----------------------------------------------------------------------
+
+QList<QPair<int, int>> Arduino::CompareCrcTable(void)
+{
+    QList<QPair<int, int>> ranges;
+    const quint8 *table = reinterpret_cast<const quint8 *>(crcTable.constData());
+    int blockSize = 1 << VERIFY_BLOCK_SHIFT;
+
+    for(int block = 0, start = 0; start < maxBufferSize; block++, start += blockSize)
+    {
+        int length = qMin(blockSize, maxBufferSize - start);
+        const quint8 *entry = table + block * 4;
+        quint32 crc = entry[0] | (entry[1] << 8) | (entry[2] << 16) | (static_cast<quint32>(entry[3]) << 24);
+        QByteArray expected = ImageData(start, length);
+        if(crc == Crc32(expected.constData(), expected.length())) {
+            continue;
+        }
+
+        // adjacent blocks go out as one read
+        if(!ranges.isEmpty() && ranges.last().second == start - 1) {
+            ranges.last().second = start + length - 1;
+        }
+        else {
+            ranges.append(qMakePair(start, start + length - 1));
+        }
+    }
+    return ranges;
+}
+//----------------------------------------------------------------------
+
+void Arduino::RequestVerifyRange(void)
+{
+    const QPair<int, int> &range = verifyRanges.first();
+    verifyOffset = range.first;
+    verifyReading = true;
+
+    port->write(BuildFrame(FRAME_READ, RangePayload(range.first, range.second)));
+}
+//----------------------------------------------------------------------
+
+bool Arduino::ReadBytes(const QVector<int> &addresses, QByteArray &values)
+{
+    QByteArray entries;
+    for(int address : addresses) {
+        entries.append(AddressBytes(address));
+    }
+    return AccessBytes(false, entries, values);
+}
+//----------------------------------------------------------------------
+
+bool Arduino::WriteBytes(const QVector<QPair<int, quint8>> &bytes, QByteArray &values)
+{
+    QByteArray entries;
+    for(const QPair<int, quint8> &byte : bytes)
+    {
+        entries.append(AddressBytes(byte.first));
+        entries.append(static_cast<char>(byte.second));
+    }
+    return AccessBytes(true, entries, values);
+}
+//----------------------------------------------------------------------
+
+int Arduino::ReadByte(int address)
+{
+    QByteArray values;
+    if(!ReadBytes(QVector<int>() << address, values)) {
+        return -1;
+    }
+    return static_cast<quint8>(values[0]);
+}
+//----------------------------------------------------------------------
+
+bool Arduino::WriteByte(int address, quint8 value)
+{
+    QByteArray values;
+    return WriteBytes(QVector<QPair<int, quint8>>() << qMakePair(address, value), values);
+}
+//----------------------------------------------------------------------
+
+bool Arduino::AccessBytes(bool write, const QByteArray &entries, QByteArray &values)
+{
+    int entryLength = AddressLength() + (write ? 1 : 0);
+    values.clear();
+
+    if(frameProtocol && protocolVersion < BYTE_ACCESS_VERSION)
+    {
+        emit ErrorSignal(QString("Firmware has no byte access"));
+        return false;
+    }
+
+    if(frameProtocol)
+    {
+        // as many entries per frame as fit in the largest block
+        int batchLength = (maxBlockLength / entryLength) * entryLength;
+        for(int offset = 0; offset < entries.length(); offset += batchLength)
+        {
+            QByteArray batch = entries.mid(offset, batchLength);
+            int count = batch.length() / entryLength;
+
+            frameBuffer.clear();
+            port->write(BuildFrame(write ? FRAME_WRITE_BYTES : FRAME_READ_BYTES, batch));
+
+            // programming a byte takes up to a few dozen pulses
+            Frame frame;
+            if(!WaitForFrame(frame, 500 + (write ? count * 100 : 0)))
+            {
+                emit ErrorSignal(QString("No answer to byte access"));
+                return false;
+            }
+            if(frame.opcode == FRAME_ERROR)
+            {
+                emit ErrorSignal(FrameErrorMessage(frame.payload));
+                return false;
+            }
+            if(frame.opcode != FRAME_BYTES || frame.payload.length() != count)
+            {
+                emit ErrorSignal(QString("Unexpected byte access answer"));
+                return false;
+            }
+            values.append(frame.payload);
+        }
+        return true;
+    }
+
+    // RDBT and WRBT take one byte each, padded to 16 bytes to skip the read timeout
+    const char *response = write ? RESPONSE_WRITE_BYTE : RESPONSE_READ_BYTE;
+    for(int offset = 0; offset < entries.length(); offset += entryLength)
+    {
+        const quint8 *entry = reinterpret_cast<const quint8 *>(entries.constData() + offset);
+        QByteArray command = write ? MESSAGE_WRITE_BYTE : MESSAGE_READ_BYTE;
+        command.append(QString("%1").arg(entry[0] | (entry[1] << 8), 4, 16, QChar('0')).toLatin1());
+        if(write) {
+            command.append(QString("%1").arg(entry[2], 2, 16, QChar('0')).toLatin1());
+        }
+        port->write(command.leftJustified(16, ' '));
+
+        QByteArray readData;
+        bool answered = WaitForResponse(readData, response, 1500);
+        int index = readData.indexOf(response);
+        if(answered)
+        {
+            // wait for the value digits behind the response tag
+            while(readData.length() < index + 10 && port->waitForReadyRead(500)) {
+                readData.append(port->readAll());
+            }
+        }
+
+        bool ok = false;
+        int value = answered ? readData.mid(index + 8, 2).toInt(&ok, 16) : 0;
+        if(!ok)
+        {
+            index = readData.indexOf(RESPONSE_ERROR);
+            emit ErrorSignal(index != -1 ? QString(readData.mid(index + 8)).trimmed() : QString("No answer to byte access"));
+            return false;
+        }
+        values.append(static_cast<char>(value));
+    }
+    return true;
+}
+//----------------------------------------------------------------------
+
+bool Arduino::WaitForResponse(QByteArray &readData, const QByteArray &response, int timeout)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    while(readData.indexOf(response, 0) == -1)
+    {
+        if(readData.indexOf(RESPONSE_ERROR, 0) != -1) {
+            return false;
+        }
+
+        int remaining = timeout - static_cast<int>(timer.elapsed());
+        if(remaining <= 0 || !port->waitForReadyRead(remaining)) {
+            return false;
+        }
+        readData.append(port->readAll());
+    }
+    return true;
+}
+//----------------------------------------------------------------------
+
+bool Arduino::SetBaudRate(qint32 baudRate)
+{
+    if(model) {
+        return false;
+    }
+
+    qint32 currentBaudRate = serialPort->baudRate();
+    QByteArray readData;
+
+    // 8 digits make a full 16 bytes command, parsed without the read timeout
+    QByteArray command = MESSAGE_BAUD_RATE;
+    command.append(QString::number(baudRate).rightJustified(8, '0').toLatin1());
+    port->write(command);
+
+    if(!WaitForResponse(readData, RESPONSE_OK, 1500)) {
+        return false;
+    }
+
+    // firmware switched, confirm with the test pattern at the new rate
+    serialPort->setBaudRate(baudRate);
+    readData.clear();
+
+    QByteArray test = MESSAGE_BAUD_TEST;
+    test.append(BAUD_TEST_PATTERN);
+    port->write(test);
+
+    QByteArray expected = RESPONSE_BAUD_TEST;
+    expected.append(BAUD_TEST_PATTERN);
+    if(WaitForResponse(readData, expected, 500)) {
+        return true;
+    }
+
+    serialPort->setBaudRate(currentBaudRate);
+    QThread::msleep(static_cast<unsigned long>(BAUD_TEST_TIMEOUT + 200));
+    ClearPort();
+    return false;
+}
+//----------------------------------------------------------------------
+
+quint16 Arduino::Crc16(const char *data, int length)
+{
+    // CRC-16/CCITT, 0x1021 polynomial, 0xFFFF initial value
+    quint16 crc = 0xFFFF;
+    for(int i = 0; i < length; i++)
+    {
+        crc ^= static_cast<quint16>(static_cast<quint8>(data[i]) << 8);
+        for(int j = 0; j < 8; j++) {
+            crc = (crc & 0x8000) ? static_cast<quint16>((crc << 1) ^ 0x1021) : static_cast<quint16>(crc << 1);
+        }
+    }
+    return crc;
+}
+//----------------------------------------------------------------------
+
+quint32 Arduino::Crc32(const char *data, int length)
+{
+    // CRC-32 as in zlib, the firmware uses the same polynomial a nibble at a time
+    quint32 crc = 0xFFFFFFFF;
+    for(int i = 0; i < length; i++)
+    {
+        crc ^= static_cast<quint8>(data[i]);
+        for(int j = 0; j < 8; j++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+        }
+    }
+    return ~crc;
+}
+//----------------------------------------------------------------------
+
+QByteArray Arduino::BuildFrame(quint8 opcode, const QByteArray &payload)
+{
+    QByteArray frame;
+    frame.reserve(FRAME_HEADER_LEN + payload.length() + FRAME_CRC_LEN);
+    frame.append(FRAME_SYNC);
+    frame.append(static_cast<char>(opcode));
+    frame.append(static_cast<char>(txSequence++));
+    frame.append(static_cast<char>(payload.length()));
+    frame.append(payload);
+
+    quint16 crc = Crc16(frame.constData() + 1, frame.length() - 1);
+    frame.append(static_cast<char>(crc & 0xFF));
+    frame.append(static_cast<char>(crc >> 8));
+    return frame;
+}
+//----------------------------------------------------------------------
+
+Arduino::FRAME_STATUS Arduino::TakeFrame(Frame &frame)
+{
+    // drop anything before the sync byte
+    int start = frameBuffer.indexOf(FRAME_SYNC);
+    if(start == -1)
+    {
+        frameBuffer.clear();
+        return FRAME_INCOMPLETE;
+    }
+    frameBuffer.remove(0, start);
+
+    if(frameBuffer.length() < FRAME_HEADER_LEN) {
+        return FRAME_INCOMPLETE;
+    }
+
+    const char *data = frameBuffer.constData();
+    int length = static_cast<quint8>(data[3]);
+    if(frameBuffer.length() < FRAME_HEADER_LEN + length + FRAME_CRC_LEN) {
+        return FRAME_INCOMPLETE;
+    }
+
+    quint16 crc = static_cast<quint16>(static_cast<quint8>(data[FRAME_HEADER_LEN + length])
+                                       | (static_cast<quint8>(data[FRAME_HEADER_LEN + length + 1]) << 8));
+    if(crc != Crc16(data + 1, FRAME_HEADER_LEN - 1 + length))
+    {
+        frameBuffer.remove(0, 1);
+        return FRAME_BAD_CRC;
+    }
+
+    frame.opcode = static_cast<quint8>(data[1]);
+    frame.sequence = static_cast<quint8>(data[2]);
+    frame.payload = frameBuffer.mid(FRAME_HEADER_LEN, length);
+    frameBuffer.remove(0, FRAME_HEADER_LEN + length + FRAME_CRC_LEN);
+
+    bool inSequence = (frame.sequence == rxSequence);
+    rxSequence = static_cast<quint8>(frame.sequence + 1);
+    return inSequence ? FRAME_VALID : FRAME_BAD_SEQUENCE;
+}
+//----------------------------------------------------------------------
+
+QString Arduino::FrameStatusMessage(FRAME_STATUS status)
+{
+    switch(status)
+    {
+        case FRAME_BAD_CRC:
+            return QString("Frame CRC mismatch");
+        case FRAME_BAD_SEQUENCE:
+            return QString("Frame lost");
+        default:
+            return QString();
+    }
+}
+//----------------------------------------------------------------------
+
+QString Arduino::FrameErrorMessage(const QByteArray &payload)
+{
+    const quint8 *data = reinterpret_cast<const quint8 *>(payload.constData());
+    int code = payload.length() ? data[0] : 0;
+    int n = AddressLength();
+
+    switch(code)
+    {
+        case ERROR_CRC:
+            return QString("Command CRC mismatch");
+        case ERROR_NO_CHIP:
+            return QString("No chip selected");
+        case ERROR_LOW_VOLTAGE:
+            if(payload.length() >= 3) {
+                return QString("Low programming voltage (%1V)").arg((data[1] | (data[2] << 8)) / 100.0, 0, 'f', 2);
+            }
+            break;
+        case ERROR_BLOCK:
+            if(payload.length() >= 2 + n) {
+                return QString("%1 bytes received for block 0x%2").arg(data[1]).arg(AddressAt(payload, 2), 0, 16);
+            }
+            break;
+        case ERROR_VERIFY:
+            if(payload.length() >= 3 + n)
+            {
+                return QString("Wrote 0x%1, read 0x%2, address 0x%3").arg(data[1 + n], 0, 16).arg(data[2 + n], 0, 16)
+                        .arg(AddressAt(payload, 1), 0, 16);
+            }
+            break;
+        case ERROR_NOT_ERASED:
+            if(payload.length() >= 3 + n)
+            {
+                return QString("Can't write 0x%1 over 0x%2, address 0x%3, chip not erased").arg(data[1 + n], 0, 16).arg(data[2 + n], 0, 16)
+                        .arg(AddressAt(payload, 1), 0, 16);
+            }
+            break;
+        case ERROR_RANGE:
+            return QString("Address range out of chip");
+        case ERROR_ABORTED:
+            if(payload.length() >= 1 + n) {
+                return QString("Aborted at 0x%1").arg(AddressAt(payload, 1), 0, 16);
+            }
+            return QString("Aborted");
+        case ERROR_BUSY:
+            return QString("Operation still running");
+        case ERROR_UNKNOWN_COMMAND:
+        default:
+            break;
+    }
+    return QString("Unknown command");
+}
+//----------------------------------------------------------------------
+
+void Arduino::FrameOperationError(const QString &message)
+{
+    QObject::disconnect(serialDataConnection);
+    emit ErrorSignal(message);
+    emit SerialOperationCompleteSignal();
+}
+//----------------------------------------------------------------------
+
+bool Arduino::DetectFrameProtocol(void)
+{
+    QByteArray readData;
+    QElapsedTimer timer;
+    timer.start();
+
+    frameBuffer.clear();
+    port->write(BuildFrame(FRAME_HELLO));
+
+    // legacy firmware takes a second to give up on the frame and answers ERR
+    while(timer.elapsed() < 1500)
+    {
+        if(!port->waitForReadyRead(100)) {
+            continue;
+        }
+        QByteArray data = port->readAll();
+        readData.append(data);
+        frameBuffer.append(data);
+
+        Frame frame;
+        FRAME_STATUS status = TakeFrame(frame);
+        if((status == FRAME_VALID || status == FRAME_BAD_SEQUENCE) && frame.opcode == FRAME_INFO && frame.payload.length() >= 2)
+        {
+            frameProtocol = true;
+            protocolVersion = static_cast<quint8>(frame.payload[0]);
+            frameBlockLength = static_cast<quint8>(frame.payload[1]);
+            maxBlockLength = frame.payload.length() >= 4 ? static_cast<quint8>(frame.payload[3]) : frameBlockLength;
+            capabilities = frame.payload.length() >= 3 ? static_cast<quint8>(frame.payload[2]) : 0;
+            compression = false;
+            wideAddresses = false;
+            rxSequence = static_cast<quint8>(frame.sequence + 1);
+            frameBuffer.clear();
+            return true;
+        }
+
+        if(readData.indexOf(RESPONSE_ERROR, 0) != -1) {
+            break;
+        }
+    }
+
+    frameProtocol = false;
+    capabilities = 0;
+    compression = false;
+    wideAddresses = false;
+    frameBuffer.clear();
+    ClearPort();
+    return false;
+}
+//----------------------------------------------------------------------
+
+bool Arduino::WaitForFrame(Frame &frame, int timeout)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    for(;;)
+    {
+        FRAME_STATUS status = TakeFrame(frame);
+        if(status == FRAME_VALID) {
+            return true;
+        }
+        if(status != FRAME_INCOMPLETE) {
+            return false;
+        }
+
+        int remaining = timeout - static_cast<int>(timer.elapsed());
+        if(remaining <= 0 || !port->waitForReadyRead(remaining)) {
+            return false;
+        }
+        frameBuffer.append(port->readAll());
+    }
+}
+//----------------------------------------------------------------------
+
+bool Arduino::SetCompression(bool enable)
+{
+    if(!frameProtocol || !(capabilities & CAPABILITY_RLE))
+    {
+        compression = false;
+        return !enable;
+    }
+
+    frameBuffer.clear();
+    quint8 options = (enable ? CAPABILITY_RLE : 0) | (wideAddresses ? CAPABILITY_WIDE_ADDRESS : 0);
+    port->write(BuildFrame(FRAME_OPTIONS, QByteArray(1, static_cast<char>(options))));
+
+    Frame frame;
+    if(!WaitForFrame(frame, 500) || frame.opcode != FRAME_OK)
+    {
+        compression = false;
+        return false;
+    }
+
+    compression = enable;
+    return true;
+}
+//----------------------------------------------------------------------
+
+bool Arduino::SetWideAddresses(bool enable)
+{
+    if(!frameProtocol || protocolVersion < WIDE_ADDRESS_VERSION || !(capabilities & CAPABILITY_WIDE_ADDRESS))
+    {
+        wideAddresses = false;
+        return !enable;
+    }
+
+    // OPTIONS carries every flag, compression stays as it is
+    frameBuffer.clear();
+    quint8 options = (compression ? CAPABILITY_RLE : 0) | (enable ? CAPABILITY_WIDE_ADDRESS : 0);
+    port->write(BuildFrame(FRAME_OPTIONS, QByteArray(1, static_cast<char>(options))));
+
+    Frame frame;
+    if(!WaitForFrame(frame, 500) || frame.opcode != FRAME_OK) {
+        return false;
+    }
+
+    wideAddresses = enable;
+    return true;
+}
+//----------------------------------------------------------------------
+
+QByteArray Arduino::RleEncode(const QByteArray &input)
+{
+    // same token format as the firmware: 0x00..0x7F = (n + 1) literal bytes,
+    // 0x80..0xFF = next byte repeated (n & 0x7F) + 1 times
+    QByteArray output;
+    const char *data = input.constData();
+    int length = input.length();
+    int literalStart = 0;
+
+    auto emitLiterals = [&](int end)
+    {
+        while(literalStart < end)
+        {
+            int count = qMin(end - literalStart, RLE_MAX_LITERAL);
+            output.append(static_cast<char>(count - 1));
+            output.append(data + literalStart, count);
+            literalStart += count;
+        }
+    };
+
+    for(int i = 0; i < length; )
+    {
+        int run = 1;
+        while(i + run < length && run < RLE_MAX_RUN && data[i + run] == data[i]) {
+            run++;
+        }
+
+        if(run >= RLE_MIN_RUN)
+        {
+            emitLiterals(i);
+            output.append(static_cast<char>(0x80 | (run - 1)));
+            output.append(data[i]);
+            literalStart = i + run;
+        }
+        i += run;
+    }
+    emitLiterals(length);
+
+    return output;
+}
+//----------------------------------------------------------------------
+
+bool Arduino::RleDecode(const QByteArray &input, QByteArray &output)
+{
+    const quint8 *data = reinterpret_cast<const quint8 *>(input.constData());
+    int length = input.length();
+
+    for(int i = 0; i < length; )
+    {
+        quint8 token = data[i++];
+        int count = (token & 0x7F) + 1;
+        if(token & 0x80)
+        {
+            if(i >= length) {
+                return false;
+            }
+            output.append(count, static_cast<char>(data[i++]));
+        }
+        else
+        {
+            if(i + count > length) {
+                return false;
+            }
+            output.append(reinterpret_cast<const char *>(data + i), count);
+            i += count;
+        }
+    }
+    return true;
+}
+//----------------------------------------------------------------------
+
+int Arduino::GetBlockLength(void)
+{
+    return frameProtocol ? frameBlockLength : LEGACY_BLOCK_LEN;
+}
+//----------------------------------------------------------------------
+
+int Arduino::GetMaxBlockLength(void)
+{
+    return frameProtocol ? maxBlockLength : LEGACY_BLOCK_LEN;
+}
+//----------------------------------------------------------------------
+
+bool Arduino::SetBlockLength(int length)
+{
+    if(length == GetBlockLength()) {
+        return true;
+    }
+    if(!frameProtocol || length > maxBlockLength) {
+        return false;
+    }
+
+    frameBuffer.clear();
+    QByteArray payload;
+    payload.append(static_cast<char>((compression ? CAPABILITY_RLE : 0) | (wideAddresses ? CAPABILITY_WIDE_ADDRESS : 0)));
+    payload.append(static_cast<char>(length));
+    port->write(BuildFrame(FRAME_OPTIONS, payload));
+
+    Frame frame;
+    if(!WaitForFrame(frame, 500) || frame.opcode != FRAME_OK) {
+        return false;
+    }
+
+    frameBlockLength = length;
+    return true;
+}
+//----------------------------------------------------------------------
+
+int Arduino::GetProtocolVersion(void)
+{
+    return frameProtocol ? protocolVersion : 0;
+}
+//----------------------------------------------------------------------
+
+void Arduino::SelectChipFrameSlot(void)
+{
+    frameBuffer.append(port->readAll());
+
+    Frame frame;
+    FRAME_STATUS status;
+    while((status = TakeFrame(frame)) != FRAME_INCOMPLETE)
+    {
+        if(status != FRAME_VALID)
+        {
+            FrameOperationError(FrameStatusMessage(status));
+            return;
+        }
+
+        if(frame.opcode == FRAME_OK && !timingPayload.isEmpty())
+        {
+            // the part's timing goes right after the select, its OK ends both
+            port->write(BuildFrame(FRAME_TIMING, timingPayload));
+            timingPayload.clear();
+        }
+        else if(frame.opcode == FRAME_OK)
+        {
+            QObject::disconnect(serialDataConnection);
+            emit SerialOperationCompleteSignal();
+            return;
+        }
+        else if(frame.opcode == FRAME_ERROR)
+        {
+            FrameOperationError(FrameErrorMessage(frame.payload));
+            return;
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+void Arduino::ReadChipFrameSlot(void)
+{
+    frameTimer->start();
+    QByteArray readData = port->readAll();
+    transferStatistics.wireBytes += readData.length();
+    frameBuffer.append(readData);
+
+    Frame frame;
+    FRAME_STATUS status;
+    while((status = TakeFrame(frame)) != FRAME_INCOMPLETE)
+    {
+        if(status != FRAME_VALID)
+        {
+            FrameOperationError(FrameStatusMessage(status));
+            return;
+        }
+
+        QByteArray data;
+        switch(frame.opcode)
+        {
+            case FRAME_DATA:
+            case FRAME_DATA_RLE:
+                if(frame.opcode == FRAME_DATA) {
+                    data = frame.payload;
+                }
+                else if(!RleDecode(frame.payload, data))
+                {
+                    FrameOperationError(QString("Invalid compressed data"));
+                    return;
+                }
+                if(!StoreReadData(data))
+                {
+                    FrameOperationError(QString("Can't store the image: %1").arg(imageDevice->errorString()));
+                    return;
+                }
+                break;
+            case FRAME_OK:
+                if(readReceived != readLength)
+                {
+                    FrameOperationError(QString("Read %1 bytes, expected %2").arg(readReceived).arg(readLength));
+                    return;
+                }
+                transferStatistics.dataBytes = readReceived;
+                FinishTransfer();
+                QObject::disconnect(serialDataConnection);
+                emit ReadCompleteSignal();
+                emit SerialOperationCompleteSignal();
+                return;
+            case FRAME_ERROR:
+                FrameOperationError(FrameErrorMessage(frame.payload));
+                return;
+            default:
+                break;
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+void Arduino::WriteChipFrameSlot(void)
+{
+    frameTimer->start(WriteFrameTimeout());
+    frameBuffer.append(port->readAll());
+
+    Frame frame;
+    FRAME_STATUS status;
+    QString errorMessage;
+    while((status = TakeFrame(frame)) != FRAME_INCOMPLETE)
+    {
+        if(status != FRAME_VALID)
+        {
+            errorMessage = FrameStatusMessage(status);
+            break;
+        }
+
+        if(frame.opcode == FRAME_BLOCK)
+        {
+            int blockAddress = AddressAt(frame.payload, 0);
+            if(blockAddress != writeAddress)
+            {
+                errorMessage = QString("Invalid block %1 received, expected %2").arg(blockAddress, 0, 16).arg(writeAddress, 0, 16);
+                break;
+            }
+            SendWriteBlock(writeAddress);
+        }
+        else if(frame.opcode == FRAME_CREDIT && frame.payload.length() >= 1)
+        {
+            writeCredits = static_cast<quint8>(frame.payload[0]);
+            FillWriteWindow();
+        }
+        else if(frame.opcode == FRAME_OK)
+        {
+            if(frame.payload.length() >= 2)
+            {
+                transferStatistics.skippedBytes += static_cast<quint8>(frame.payload[0]);
+                transferStatistics.programmedBytes += static_cast<quint8>(frame.payload[1]);
+            }
+            int blockLength = qMin(frameBlockLength, writeRanges.first().second + 1 - writeAddress);
+            if(frame.payload.length() >= 2 + AddressLength())
+            {
+                // 16-bit frames wrap after the last block of a 27C512
+                int nextAddress = AddressAt(frame.payload, 2);
+                int expectedAddress = wideAddresses ? writeAddress + blockLength : (writeAddress + blockLength) & 0xFFFF;
+                if(nextAddress != expectedAddress)
+                {
+                    errorMessage = QString("Acknowledged up to %1, expected %2").arg(nextAddress, 0, 16).arg(writeAddress + blockLength, 0, 16);
+                    break;
+                }
+            }
+            writtenBytes += blockLength;
+            ReportProgress(writtenBytes);
+            writeAddress += blockLength;
+            if(writeAddress <= writeRanges.first().second)
+            {
+                if(writeCredits)
+                {
+                    writeInFlight--;
+                    FillWriteWindow();
+                }
+                continue;
+            }
+
+            // the pulse histogram of the range follows its last block
+            if(protocolVersion >= PULSE_INFO_VERSION)
+            {
+                pulseInfoPending = true;
+                continue;
+            }
+            if(NextWriteRange()) {
+                return;
+            }
+        }
+        else if(frame.opcode == FRAME_PULSE_INFO && pulseInfoPending)
+        {
+            const quint8 *data = reinterpret_cast<const quint8 *>(frame.payload.constData());
+            int bins = frame.payload.length() / 4;
+            if(transferStatistics.pulseHistogram.size() < bins) {
+                transferStatistics.pulseHistogram.resize(bins);
+            }
+            for(int i = 0; i < bins; i++) {
+                transferStatistics.pulseHistogram[i] += data[i * 4] | (data[i * 4 + 1] << 8) | (data[i * 4 + 2] << 16)
+                        | (static_cast<quint32>(data[i * 4 + 3]) << 24);
+            }
+            if(NextWriteRange()) {
+                return;
+            }
+        }
+        else if(frame.opcode == FRAME_ERROR)
+        {
+            errorMessage = FrameErrorMessage(frame.payload);
+            break;
+        }
+    }
+
+    if(!errorMessage.isEmpty())
+    {
+        QObject::disconnect(serialDataConnection);
+        emit WriteErrorSignal(static_cast<quint32>(writeAddress), errorMessage);
+        emit SerialOperationCompleteSignal();
+    }
+}
+//----------------------------------------------------------------------
+
+void Arduino::ReadVoltageFrameSlot(void)
+{
+    frameBuffer.append(port->readAll());
+
+    Frame frame;
+    FRAME_STATUS status;
+    while((status = TakeFrame(frame)) != FRAME_INCOMPLETE)
+    {
+        if(status != FRAME_VALID)
+        {
+            FrameOperationError(FrameStatusMessage(status));
+            return;
+        }
+
+        if(frame.opcode == FRAME_VOLTAGE_INFO && frame.payload.length() >= 2)
+        {
+            QObject::disconnect(serialDataConnection);
+            emit VoltageUpdatedSignal(static_cast<quint8>(frame.payload[0]) | (static_cast<quint8>(frame.payload[1]) << 8));
+            emit SerialOperationCompleteSignal();
+            return;
+        }
+        else if(frame.opcode == FRAME_ERROR)
+        {
+            FrameOperationError(FrameErrorMessage(frame.payload));
+            return;
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+void Arduino::BlankCheckFrameSlot(void)
+{
+    frameTimer->start();
+    QByteArray readData = port->readAll();
+    transferStatistics.wireBytes += readData.length();
+    frameBuffer.append(readData);
+
+    int n = AddressLength();
+    Frame frame;
+    FRAME_STATUS status;
+    while((status = TakeFrame(frame)) != FRAME_INCOMPLETE)
+    {
+        if(status != FRAME_VALID)
+        {
+            FrameOperationError(FrameStatusMessage(status));
+            return;
+        }
+
+        if(frame.opcode == FRAME_BLANK_INFO && frame.payload.length() >= 9 + n)
+        {
+            const quint8 *data = reinterpret_cast<const quint8 *>(frame.payload.constData());
+            int firstProgrammed = AddressAt(frame.payload, 1);
+            const quint8 *counts = data + 1 + n;
+            int programmedBytes = static_cast<int>(counts[0] | (counts[1] << 8) | (counts[2] << 16) | (static_cast<quint32>(counts[3]) << 24));
+            int programmedBits = static_cast<int>(counts[4] | (counts[5] << 8) | (counts[6] << 16) | (static_cast<quint32>(counts[7]) << 24));
+
+            FinishTransfer();
+            QObject::disconnect(serialDataConnection);
+            emit BlankCheckSignal(data[0] != 0, firstProgrammed, programmedBytes, programmedBits);
+            emit SerialOperationCompleteSignal();
+            return;
+        }
+        else if(frame.opcode == FRAME_ERROR)
+        {
+            FrameOperationError(FrameErrorMessage(frame.payload));
+            return;
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+void Arduino::VerifyChipFrameSlot(void)
+{
+    frameTimer->start();
+    QByteArray readData = port->readAll();
+    transferStatistics.wireBytes += readData.length();
+    frameBuffer.append(readData);
+
+    Frame frame;
+    FRAME_STATUS status;
+    while((status = TakeFrame(frame)) != FRAME_INCOMPLETE)
+    {
+        if(status != FRAME_VALID)
+        {
+            FrameOperationError(FrameStatusMessage(status));
+            return;
+        }
+
+        QByteArray data;
+        switch(frame.opcode)
+        {
+            case FRAME_CRC_TABLE:
+                crcTable.append(frame.payload);
+                ReportProgress(qMin(maxBufferSize, (crcTable.length() / 4) << VERIFY_BLOCK_SHIFT));
+                break;
+            case FRAME_DATA:
+            case FRAME_DATA_RLE:
+                if(frame.opcode == FRAME_DATA) {
+                    data = frame.payload;
+                }
+                else if(!RleDecode(frame.payload, data))
+                {
+                    FrameOperationError(QString("Invalid compressed data"));
+                    return;
+                }
+                if(!verifyReading || verifyOffset + data.length() > verifyRanges.first().second + 1)
+                {
+                    FrameOperationError(QString("Unexpected data at 0x%1").arg(verifyOffset, 0, 16));
+                    return;
+                }
+                if(imageStreaming) {
+                    ChipImage::Accumulate(verifyComparison, data, ImageData(verifyOffset, data.length()), verifyOffset);
+                }
+                else {
+                    readBuffer.replace(verifyOffset, data.length(), data);
+                }
+                verifyOffset += data.length();
+                ReportProgress(verifyOffset);
+                break;
+            case FRAME_OK:
+                if(!verifyReading)
+                {
+                    int blocks = (maxBufferSize + (1 << VERIFY_BLOCK_SHIFT) - 1) >> VERIFY_BLOCK_SHIFT;
+                    if(crcTable.length() != blocks * 4)
+                    {
+                        FrameOperationError(QString("Received %1 checksums, expected %2").arg(crcTable.length() / 4).arg(blocks));
+                        return;
+                    }
+                    verifyRanges = CompareCrcTable();
+                }
+                else
+                {
+                    if(verifyOffset != verifyRanges.first().second + 1)
+                    {
+                        FrameOperationError(QString("Read stopped at 0x%1, expected 0x%2").arg(verifyOffset, 0, 16)
+                                            .arg(verifyRanges.first().second + 1, 0, 16));
+                        return;
+                    }
+                    verifyRanges.removeFirst();
+                }
+
+                if(!verifyRanges.isEmpty())
+                {
+                    // an ABORT between two ranges found nothing running
+                    if(aborting)
+                    {
+                        FrameOperationError(QString("Aborted"));
+                        return;
+                    }
+                    RequestVerifyRange();
+                    break;
+                }
+
+                transferStatistics.dataBytes = maxBufferSize;
+                FinishTransfer();
+                QObject::disconnect(serialDataConnection);
+                emit ReadCompleteSignal();
+                emit SerialOperationCompleteSignal();
+                return;
+            case FRAME_ERROR:
+                FrameOperationError(FrameErrorMessage(frame.payload));
+                return;
+            default:
+                break;
+        }
+    }
+}
+//----------------------------------------------------------------------
+//----------------------------------------------------------------------
@@ -0,0 +1,351 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+//----------------------------------------------------------------------
+#include <QObject>
+#include <QSerialPort>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QPair>
+#include <QVector>
+#include "streamparser.h"
+#include "chipimage.h"
+//----------------------------------------------------------------------
+
+class EpromModel;
+//----------------------------------------------------------------------
+
+// Lives in the I/O thread with its serial port: operations are slots the GUI
+// invokes queued, the getters are only read between operations, after the
+// signal that ended the last one
+class Arduino : public QObject
+{
+    Q_OBJECT
+    friend class EpromModel; // answers with the same frames
+
+private:
+    const char *MESSAGE_SELECT_NONE    = "!@#$NONE";
+    const char *MESSAGE_SELECT_C16     = "!@#$C16 ";
+    const char *MESSAGE_SELECT_C32     = "!@#$C32 ";
+    const char *MESSAGE_SELECT_C64     = "!@#$C64 ";
+    const char *MESSAGE_SELECT_C128    = "!@#$C128";
+    const char *MESSAGE_SELECT_C256    = "!@#$C256";
+    const char *MESSAGE_SELECT_C512    = "!@#$C512";
+    const char *MESSAGE_VOLTAGE_INFO   = "!@#$VINF";
+    const char *MESSAGE_READ_CHIP      = "!@#$READ";
+    const char *MESSAGE_WRITE_CHIP     = "!@#$WRIT";
+    const char *RESPONSE_READ_CHIP     = "$#@!READ";
+    const char *RESPONSE_WRITE_CHIP    = "$#@!WRIT";
+    const char *RESPONSE_ERROR         = "$#@!ERR ";
+    const char *RESPONSE_BLOCK_REQUEST = "$#@!BLCK";
+    const char *RESPONSE_OK            = "$#@!OK  ";
+    const char *RESPONSE_VOLTAGEINFO   = "$#@!VINF";
+    const char *MESSAGE_READ_BYTE      = "!@#$RDBT";
+    const char *MESSAGE_WRITE_BYTE     = "!@#$WRBT";
+    const char *RESPONSE_READ_BYTE     = "$#@!RDBT";
+    const char *RESPONSE_WRITE_BYTE    = "$#@!WRBT";
+    const char *MESSAGE_ABORT          = "!@#$ABRT";
+    const char *MESSAGE_BAUD_RATE      = "!@#$BAUD";
+    const char *MESSAGE_BAUD_TEST      = "!@#$BTST";
+    const char *RESPONSE_BAUD_TEST     = "$#@!BTST";
+    const QByteArray BAUD_TEST_PATTERN = QByteArray("\x55\xAA\x00\xFF\x0F\xF0\x33\xCC", 8);
+    const int BAUD_TEST_TIMEOUT = 1000; // firmware falls back to the old rate after this
+    const char *PROGRAMMER_NAME = "Arduino 27CXXX EEPROM programmer";
+    const char *MODEL_PORT_PREFIX = "model:"; // a software chip backed by the file after it
+    const int LEGACY_BLOCK_LEN = 16;
+    const int LEGACY_RESPONSE_TIMEOUT = 1000; // ms for an answer that needs no programming
+    const int LEGACY_SERIAL_TIMEOUT = 1000; // firmware gives up on a missing block after this
+    const int ABORT_DELAY = 100; // ms for older firmware to go quiet before the port is cleared
+    const int ABORT_TIMEOUT = 1000; // ms past the running block for an ABORT to be answered
+    const int FRAME_RESPONSE_TIMEOUT = 1000; // ms for a frame that needs no programming
+    const int SCAN_TIMEOUT_PER_KB = 500; // the slowest address bus reads about 3 bytes a ms
+
+    // binary frames: sync, opcode, sequence, length, payload, CRC16 (LSB first)
+    const char FRAME_SYNC = static_cast<char>(0xA5);
+    const int FRAME_HEADER_LEN = 4;
+    const int FRAME_CRC_LEN = 2;
+
+    enum FRAME_OPCODE {
+        FRAME_HELLO = 0x01,
+        FRAME_SELECT = 0x02,
+        FRAME_VOLTAGE = 0x03,
+        FRAME_READ = 0x04,
+        FRAME_WRITE = 0x05,
+        FRAME_DATA = 0x06,
+        FRAME_OPTIONS = 0x07,
+        FRAME_DATA_RLE = 0x08,
+        FRAME_BLANK = 0x09,
+        FRAME_CRC = 0x0A,
+        FRAME_READ_BYTES = 0x0B,
+        FRAME_WRITE_BYTES = 0x0C,
+        FRAME_ABORT = 0x0D,
+        FRAME_TIMING = 0x0F,
+        FRAME_OK = 0x40,
+        FRAME_ERROR = 0x41,
+        FRAME_BLOCK = 0x42,
+        FRAME_VOLTAGE_INFO = 0x43,
+        FRAME_INFO = 0x44,
+        FRAME_BLANK_INFO = 0x45,
+        FRAME_CRC_TABLE = 0x46,
+        FRAME_PULSE_INFO = 0x47,
+        FRAME_CREDIT = 0x48,
+        FRAME_BYTES = 0x49
+    };
+
+    enum FRAME_ERROR_CODE {
+        ERROR_UNKNOWN_COMMAND = 1,
+        ERROR_CRC = 2,
+        ERROR_NO_CHIP = 3,
+        ERROR_LOW_VOLTAGE = 4,
+        ERROR_BLOCK = 5,
+        ERROR_VERIFY = 6,
+        ERROR_RANGE = 7,
+        ERROR_NOT_ERASED = 8,
+        ERROR_ABORTED = 9,
+        ERROR_BUSY = 10
+    };
+
+    enum FRAME_STATUS {
+        FRAME_INCOMPLETE,
+        FRAME_VALID,
+        FRAME_BAD_CRC,
+        FRAME_BAD_SEQUENCE
+    };
+
+    struct Frame {
+        quint8 opcode;
+        quint8 sequence;
+        QByteArray payload;
+    };
+
+    const quint8 CAPABILITY_RLE = 0x01;
+    const quint8 CAPABILITY_WIDE_ADDRESS = 0x02; // 32-bit addresses, firmware with the third address stage
+    const int RLE_MIN_RUN = 3;
+    const int RLE_MAX_RUN = 128;
+    const int RLE_MAX_LITERAL = 63;
+    const int BLANK_CHECK_VERSION = 3;
+    const int CRC_VERIFY_VERSION = 4;
+    const int VERIFY_BLOCK_SHIFT = 10; // 1 KB blocks, 256 bytes of table for a 27C512
+    const int RANGE_READ_VERSION = 4;
+    const int SPARSE_WRITE_VERSION = 6;
+    const int PULSE_INFO_VERSION = 7;
+    const int BYTE_ACCESS_VERSION = 10;
+    const int ABORT_VERSION = 11;
+    const int TIMING_VERSION = 12;
+    const int WIDE_ADDRESS_VERSION = 13;
+    const int IMAGE_SCAN_BLOCKS = 256; // write blocks checked per read of a streamed image
+
+    int maxBufferSize = 0;
+    int readLength = 0;
+    QByteArray readBuffer;
+    StreamParser streamParser;
+    QByteArray writeBuffer;
+    QSerialPort *serialPort = nullptr;
+    EpromModel *model = nullptr;
+    QIODevice *port = nullptr; // the serial port, or the model in its place
+    QMetaObject::Connection serialDataConnection;
+
+    bool frameProtocol = false;
+    int protocolVersion = 0;
+    int frameBlockLength = 0;
+    int maxBlockLength = 0;
+    int writeAddress = 0;
+    quint8 txSequence = 0;
+    quint8 rxSequence = 0;
+    quint8 capabilities = 0;
+    bool compression = false;
+    bool wideAddresses = false;
+    QByteArray frameBuffer;
+    QElapsedTimer transferTimer;
+    QByteArray crcTable;
+    QList<QPair<int, int>> verifyRanges;
+    int verifyOffset = 0;
+    bool verifyReading = false;
+    QList<QPair<int, int>> writeRanges;
+    int writtenBytes = 0;
+    bool pulseInfoPending = false;
+    int writeCredits = 0;
+    int writeInFlight = 0;
+    int sendAddress = 0;
+    bool aborting = false;
+    QByteArray timingPayload; // sent once the chip select is answered
+    int blockTimeout = 100;
+
+    // legacy write: WRIT, then a BLCK request and an OK per block
+    QTimer *legacyTimer;
+    QByteArray legacyData;
+    int legacyBlock = 0;
+    bool legacyWriting = false;
+    bool legacyStarted = false;
+    bool legacyAcknowledging = false;
+
+    QTimer *abortTimer; // gives up on an ABORT a reset or lost frame never answers
+
+    // restarted by every answer of a streamed read, write, blank check or CRC
+    QTimer *frameTimer;
+    bool frameWriting = false;
+
+    // images bigger than is sensible to hold are streamed through a device,
+    // writeBuffer then only holds what WriteRange was given
+    QIODevice *imageDevice = nullptr;
+    bool imageStreaming = false;
+    int imageOffset = 0;
+    int readReceived = 0;
+    ChipImage::Comparison verifyComparison = { 0, 0, -1, QByteArray() };
+
+    void Send(const QByteArray &data);
+    void ClearPort(void);
+    qint32 NegotiateBaudRate(const QList<qint32> &baudRates);
+    bool WaitForResponse(QByteArray &readData, const QByteArray &response, int timeout);
+    static quint16 Crc16(const char *data, int length);
+    static quint32 Crc32(const char *data, int length);
+    QByteArray BuildFrame(quint8 opcode, const QByteArray &payload = QByteArray());
+    FRAME_STATUS TakeFrame(Frame &frame);
+    QString FrameErrorMessage(const QByteArray &payload);
+    QString FrameStatusMessage(FRAME_STATUS status);
+    void FrameOperationError(const QString &message);
+    bool WaitForFrame(Frame &frame, int timeout);
+    QByteArray RleEncode(const QByteArray &input);
+    bool RleDecode(const QByteArray &input, QByteArray &output);
+    void StartTransfer(int total = 0);
+    void ReportProgress(int done);
+    void FinishTransfer(void);
+    QList<QPair<int, int>> CompareCrcTable(void);
+    void RequestVerifyRange(void);
+    void SetImage(const QByteArray &data);
+    int ImageLength(void);
+    QByteArray ImageData(int address, int length);
+    bool StoreReadData(const QByteArray &data);
+    QList<QPair<int, int>> WriteRanges(void);
+    static void AppendWriteRanges(QList<QPair<int, int>> &ranges, const QByteArray &data, int address, int blockLength);
+    static int RangesLength(const QList<QPair<int, int>> &ranges);
+    int AddressLength(void);
+    QByteArray AddressBytes(int address);
+    int AddressAt(const QByteArray &payload, int offset);
+    QByteArray RangePayload(int first, int last);
+    void RequestWriteRange(void);
+    bool NextWriteRange(void);
+    int SendWriteBlock(int address);
+    void FillWriteWindow(void);
+    bool AccessBytes(bool write, const QByteArray &entries, QByteArray &values);
+    void EndLegacyWrite(const QString &error = QString());
+    int WriteFrameTimeout(void);
+    int ScanFrameTimeout(int length);
+
+private slots:
+    void SelectChipSlot(void);
+    void ReadChipSlot(void);
+    void WriteChipSlot(void);
+    void LegacyWriteTimeoutSlot(void);
+    void AbortCompleteSlot(void);
+    void AbortTimeoutSlot(void);
+    void FrameTimeoutSlot(void);
+    void ReadVoltageSlot(void);
+    void SelectChipFrameSlot(void);
+    void ReadChipFrameSlot(void);
+    void WriteChipFrameSlot(void);
+    void ReadVoltageFrameSlot(void);
+    void BlankCheckFrameSlot(void);
+    void VerifyChipFrameSlot(void);
+
+public:
+    struct TransferStatistics {
+        qint64 dataBytes;
+        qint64 wireBytes;
+        qint64 elapsed;
+        qint64 skippedBytes;
+        qint64 programmedBytes;
+        QVector<qint64> pulseHistogram; // bytes by pulses taken, the last entry holds the rest
+    };
+
+    enum CHIP_TYPE {
+        NONE,
+        C16,
+        C32,
+        C64,
+        C128,
+        C256,
+        C512,
+        C010,
+        C020,
+        C040,
+        C080
+    };
+    Q_ENUM(CHIP_TYPE)
+
+    explicit Arduino(QObject *parent = nullptr);
+    static int ChipSize(CHIP_TYPE);
+    static bool ParseChipType(const QString &, CHIP_TYPE &);
+    // rates to negotiate, fastest first unless one is known to work
+    static QList<qint32> BaudRates(qint32 first = 0);
+    // the last rate that worked on a port, kept in the settings
+    static qint32 SavedBaudRate(const QString &path);
+    static void SaveBaudRate(const QString &path, qint32 baudRate);
+    int GetChipSize(void);
+    QByteArray *GetReadBuffer(void);
+    int GetWriteLength(const QByteArray &) const;
+    bool HasBlankCheck(void);
+    bool HasCrcVerify(void);
+    // blocking, from the I/O thread or through a Qt::BlockingQueuedConnection
+    bool ReadBytes(const QVector<int> &, QByteArray &);
+    bool WriteBytes(const QVector<QPair<int, quint8>> &, QByteArray &);
+    int ReadByte(int);
+    bool WriteByte(int, quint8);
+    bool SetBaudRate(qint32);
+    bool DetectFrameProtocol(void);
+    int GetProtocolVersion(void);
+    bool SetCompression(bool);
+    bool SetWideAddresses(bool);
+    int GetBlockLength(void);
+    int GetMaxBlockLength(void);
+    TransferStatistics GetTransferStatistics(void);
+    // an empty image given to WriteChip or VerifyChip is taken from the device,
+    // ReadChip and ReadRange write to it instead of the read buffer
+    void SetImageDevice(QIODevice *);
+    bool HasImageStreaming(void);
+    ChipImage::Comparison GetComparison(void); // after a verify from the image device
+    void ResetVariables(void);
+
+public slots:
+    void Open(QString, QList<qint32>);
+    void Close(void);
+    void SelectChip(Arduino::CHIP_TYPE, QString part = QString());
+    void ReadChip(void);
+    void ReadChipBlocks(int);
+    bool ReadRange(int, int);
+    void WriteChip(QByteArray);
+    bool WriteRange(int, QByteArray);
+    void ReadVoltage(void);
+    void BlankCheck(bool);
+    void VerifyChip(QByteArray);
+    void Abort(void);
+    bool SetBlockLength(int);
+
+signals:
+    void ConnectedSignal(bool, qint32);
+    void PortErrorSignal(QString);
+    void LogSignal(QString);
+    void ProgressSignal(quint32, quint32, quint32, qint32); // done, total, bytes/s, ms left or -1
+    void ReadCompleteSignal(void);
+    void WriteCompleteSignal(void);
+    void WriteErrorSignal(quint32, QString);
+    void VoltageUpdatedSignal(double);
+    void BlankCheckSignal(bool, int, int, int);
+    void SerialOperationStartSignal(void);
+    void SerialOperationCompleteSignal(void);
+    void ErrorSignal(QString);
+
+private:
+    CHIP_TYPE selectedChipType = CHIP_TYPE::NONE;
+    TransferStatistics transferStatistics = { 0, 0, 0, 0, 0 };
+
+    // progress is counted per byte, signalled at most PROGRESS_INTERVAL apart
+    const int PROGRESS_INTERVAL = 40; // ms, 25 updates/s
+    quint32 progressTotal = 0;
+    quint32 progressDone = 0;
+    quint32 progressReported = 0;
+    qint64 progressTime = 0;
+    double progressRate = 0;
+
+};
+//----------------------------------------------------------------------
+#endif // ARDUINO_H
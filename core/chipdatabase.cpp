@@ -0,0 +1,207 @@
+#include "chipdatabase.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QStandardPaths>
+//----------------------------------------------------------------------
+
+ChipDatabase::ChipDatabase(void)
+{
+    // the firmware's own defaults, a part without chips.json programs as before
+    auto family = [this](const char *name, Arduino::CHIP_TYPE type, int size, VPP_LINE vppLine,
+                         int pulseWidth, int maxPulses, int overprogramFactor, int blockTimeout)
+    {
+        Chip chip;
+        chip.name = name;
+        chip.type = type;
+        chip.size = size;
+        chip.vppLine = vppLine;
+        chip.pulseWidth = pulseWidth;
+        chip.maxPulses = maxPulses;
+        chip.overprogramFactor = overprogramFactor;
+        chip.blockTimeout = blockTimeout;
+        chips.append(chip);
+    };
+    family("27C16", Arduino::C16, 0x0800, VPP_C16, 15000, 1, 0, 320);
+    family("27C32", Arduino::C32, 0x1000, VPP_C32, 100, 25, 3, 100);
+    family("27C64", Arduino::C64, 0x2000, VPP_OTHER, 100, 25, 3, 100);
+    family("27C128", Arduino::C128, 0x4000, VPP_OTHER, 100, 25, 3, 100);
+    family("27C256", Arduino::C256, 0x8000, VPP_OTHER, 100, 25, 0, 100);
+    family("27C512", Arduino::C512, 0x10000, VPP_C32, 100, 25, 0, 100);
+    family("27C010", Arduino::C010, 0x20000, VPP_OTHER, 100, 25, 0, 100);
+    family("27C020", Arduino::C020, 0x40000, VPP_OTHER, 100, 25, 0, 100);
+    family("27C040", Arduino::C040, 0x80000, VPP_OTHER, 100, 25, 0, 100);
+    family("27C080", Arduino::C080, 0x100000, VPP_C32, 100, 25, 0, 100);
+}
+//----------------------------------------------------------------------
+
+ChipDatabase &ChipDatabase::Instance(void)
+{
+    static ChipDatabase database;
+    return database;
+}
+//----------------------------------------------------------------------
+
+const QList<ChipDatabase::Chip> &ChipDatabase::GetChips(void) const
+{
+    return chips;
+}
+//----------------------------------------------------------------------
+
+const ChipDatabase::Chip *ChipDatabase::Find(const QString &name) const
+{
+    for(const Chip &chip : chips)
+    {
+        if(chip.name.compare(name, Qt::CaseInsensitive) == 0) {
+            return &chip;
+        }
+    }
+    return nullptr;
+}
+//----------------------------------------------------------------------
+
+const ChipDatabase::Chip *ChipDatabase::Find(Arduino::CHIP_TYPE type) const
+{
+    // the family entries come first, a family selects its generic part
+    for(const Chip &chip : chips)
+    {
+        if(chip.type == type) {
+            return &chip;
+        }
+    }
+    return nullptr;
+}
+//----------------------------------------------------------------------
+
+bool ChipDatabase::ParseVppLine(const QString &name, VPP_LINE &line)
+{
+    QString key = name.toUpper();
+    if(key == "C16") {
+        line = VPP_C16;
+    }
+    else if(key == "C32") {
+        line = VPP_C32;
+    }
+    else if(key == "OTHER") {
+        line = VPP_OTHER;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------
+
+bool ChipDatabase::LoadDefault(QString &error)
+{
+    // next to the executable first, then the user's configuration
+    QString fileName = QDir(QCoreApplication::applicationDirPath()).filePath(FILE_NAME);
+    if(!QFileInfo::exists(fileName)) {
+        fileName = QStandardPaths::locate(QStandardPaths::AppConfigLocation, FILE_NAME);
+    }
+    if(fileName.isEmpty()) {
+        return true;
+    }
+    return Load(fileName, error);
+}
+//----------------------------------------------------------------------
+
+bool ChipDatabase::Load(const QString &fileName, QString &error)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        error = QString("%1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if(parseError.error != QJsonParseError::NoError)
+    {
+        error = QString("%1: %2 at offset %3").arg(fileName).arg(parseError.errorString()).arg(parseError.offset);
+        return false;
+    }
+
+    // checked as a whole, a bad entry leaves the database as it was
+    QList<Chip> loaded = chips;
+    auto family = [&loaded](Arduino::CHIP_TYPE type) -> const Chip &
+    {
+        for(const Chip &chip : loaded)
+        {
+            if(chip.type == type) {
+                return chip;
+            }
+        }
+        return loaded.first();
+    };
+    const QJsonArray entries = document.object().value("chips").toArray();
+    for(int i = 0; i < entries.size(); i++)
+    {
+        QJsonObject entry = entries[i].toObject();
+        QString name = entry.value("name").toString();
+        QString where = QString("%1: chip %2").arg(fileName).arg(name.isEmpty() ? QString::number(i + 1) : name);
+
+        Arduino::CHIP_TYPE type;
+        if(name.isEmpty() || !Arduino::ParseChipType(entry.value("family").toString(), type))
+        {
+            error = QString("%1: needs a name and a family, 27C16 to 27C080").arg(where);
+            return false;
+        }
+
+        // unset fields come from the family
+        Chip chip = family(type);
+        chip.name = name;
+        chip.manufacturer = entry.value("manufacturer").toString();
+        chip.pulseWidth = entry.value("pulseWidth").toInt(chip.pulseWidth);
+        chip.maxPulses = entry.value("maxPulses").toInt(chip.maxPulses);
+        chip.overprogramFactor = entry.value("overprogram").toInt(chip.overprogramFactor);
+        chip.blockTimeout = entry.value("blockTimeout").toInt(chip.blockTimeout);
+
+        // the socket wiring decides the address lines, not the entry
+        if(entry.contains("size") && entry.value("size").toInt() != chip.size)
+        {
+            error = QString("%1: a %2 holds %3 bytes").arg(where).arg(family(type).name).arg(chip.size);
+            return false;
+        }
+        if(entry.contains("vpp") && !ParseVppLine(entry.value("vpp").toString(), chip.vppLine))
+        {
+            error = QString("%1: Vpp line is C16, C32 or OTHER").arg(where);
+            return false;
+        }
+        if(chip.pulseWidth < 1 || chip.pulseWidth > 0xFFFF || chip.maxPulses < 1 || chip.maxPulses > 0xFF
+                || chip.overprogramFactor < 0 || chip.overprogramFactor > 0xFF || chip.blockTimeout < 1)
+        {
+            error = QString("%1: timing out of range").arg(where);
+            return false;
+        }
+
+        bool replaced = false;
+        for(Chip &existing : loaded)
+        {
+            if(existing.name.compare(name, Qt::CaseInsensitive) == 0)
+            {
+                // a family keeps its type, it may only be retuned
+                if(existing.type != chip.type)
+                {
+                    error = QString("%1: is a %2 already").arg(where).arg(family(existing.type).name);
+                    return false;
+                }
+                existing = chip;
+                replaced = true;
+            }
+        }
+        if(!replaced) {
+            loaded.append(chip);
+        }
+    }
+
+    chips = loaded;
+    return true;
+}
+//----------------------------------------------------------------------
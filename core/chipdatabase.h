@@ -0,0 +1,53 @@
+#ifndef CHIPDATABASE_H
+#define CHIPDATABASE_H
+//----------------------------------------------------------------------
+#include "arduino.h"
+#include <QList>
+#include <QString>
+//----------------------------------------------------------------------
+
+// Parts the programmer knows: every part is driven as one of the socket
+// families the firmware is wired for and carries its own programming
+// timing, uploaded at chip select. The families are built in, chips.json
+// retunes them and adds parts. Loaded once at startup, before any I/O
+// thread runs, read only afterwards.
+class ChipDatabase
+{
+public:
+    // Vpp switches on the board, in the firmware's order
+    enum VPP_LINE {
+        VPP_C16,
+        VPP_C32,
+        VPP_OTHER
+    };
+
+    struct Chip {
+        QString name;
+        QString manufacturer;
+        Arduino::CHIP_TYPE type = Arduino::NONE;
+        int size = 0;
+        VPP_LINE vppLine = VPP_OTHER;
+        int pulseWidth = 100;       // us
+        int maxPulses = 25;
+        int overprogramFactor = 0;  // times the pulses taken, 0 for quick-pulse parts
+        int blockTimeout = 100;     // ms a legacy firmware gets per written block
+    };
+
+    static ChipDatabase &Instance(void);
+    bool Load(const QString &fileName, QString &error);
+    bool LoadDefault(QString &error);
+    const QList<Chip> &GetChips(void) const;
+    const Chip *Find(const QString &name) const;
+    const Chip *Find(Arduino::CHIP_TYPE type) const;
+
+private:
+    const char *FILE_NAME = "chips.json";
+
+    QList<Chip> chips;
+
+    ChipDatabase(void);
+    static bool ParseVppLine(const QString &name, VPP_LINE &line);
+};
+//----------------------------------------------------------------------
+
+#endif // CHIPDATABASE_H
@@ -0,0 +1,69 @@
+#include "chipimage.h"
+//----------------------------------------------------------------------
+
+ChipImage::Comparison ChipImage::Compare(const QByteArray &read, const QByteArray &expected)
+{
+    Comparison comparison = { 0, 0, -1, QByteArray(read.length(), CHECK_NO_ERROR) };
+    CompareBytes(comparison, read, expected, 0, comparison.checks.data());
+    return comparison;
+}
+//----------------------------------------------------------------------
+
+void ChipImage::Accumulate(Comparison &comparison, const QByteArray &read, const QByteArray &expected, int address)
+{
+    CompareBytes(comparison, read, expected, address, nullptr);
+}
+//----------------------------------------------------------------------
+
+void ChipImage::CompareBytes(Comparison &comparison, const QByteArray &read, const QByteArray &expected, int address, char *checks)
+{
+    const quint8 *dataRead = reinterpret_cast<const quint8 *>(read.constData());
+    const quint8 *fileData = reinterpret_cast<const quint8 *>(expected.constData());
+    for(int i = 0, j = qMin(read.length(), expected.length()); i < j; i++)
+    {
+        if(dataRead[i] == fileData[i]) {
+            continue;
+        }
+
+        CHECK check = ((dataRead[i] ^ fileData[i]) & fileData[i]) ? CHECK_ERROR_UNWRITABLE : CHECK_ERROR_WRITABLE;
+        if(check == CHECK_ERROR_UNWRITABLE) {
+            comparison.errors++;
+        }
+        else {
+            comparison.warnings++;
+        }
+        if(checks) {
+            checks[i] = check;
+        }
+        if(comparison.firstMismatch == -1) {
+            comparison.firstMismatch = address + i;
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+ChipImage::BlankCheck ChipImage::CheckBlank(const QByteArray &read)
+{
+    BlankCheck check = { true, -1, 0, 0 };
+
+    const quint8 *dataRead = reinterpret_cast<const quint8 *>(read.constData());
+    for(int i = 0, j = read.length(); i < j; i++)
+    {
+        quint8 programmed = static_cast<quint8>(~dataRead[i]);
+        if(!programmed) {
+            continue;
+        }
+
+        if(check.blank)
+        {
+            check.blank = false;
+            check.firstProgrammed = i;
+        }
+        check.programmedBytes++;
+        for(; programmed; programmed &= programmed - 1) {
+            check.programmedBits++;
+        }
+    }
+    return check;
+}
+//----------------------------------------------------------------------
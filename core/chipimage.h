@@ -0,0 +1,44 @@
+#ifndef CHIPIMAGE_H
+#define CHIPIMAGE_H
+//----------------------------------------------------------------------
+#include <QByteArray>
+//----------------------------------------------------------------------
+
+// Chip contents checked against an image or against the erased state.
+// Programming only clears bits, so a byte that differs is either fixable
+// by writing again or needs the chip erased first
+class ChipImage
+{
+public:
+    enum CHECK {
+        CHECK_NO_ERROR = 0,
+        CHECK_ERROR_WRITABLE = 1,   // has 1 bits the image clears
+        CHECK_ERROR_UNWRITABLE = 2  // has 0 bits the image sets, needs an erase
+    };
+
+    struct Comparison {
+        int errors;        // unwritable bytes
+        int warnings;      // writable bytes
+        int firstMismatch; // -1 if the contents match
+        QByteArray checks; // a CHECK value per byte, empty when accumulated
+    };
+
+    struct BlankCheck {
+        bool blank;
+        int firstProgrammed; // -1 if blank
+        int programmedBytes;
+        int programmedBits;
+    };
+
+    static Comparison Compare(const QByteArray &read, const QByteArray &expected);
+    // counts a chunk at the given chip address into a running comparison,
+    // for images checked piece by piece without keeping them whole
+    static void Accumulate(Comparison &comparison, const QByteArray &read, const QByteArray &expected, int address);
+    static BlankCheck CheckBlank(const QByteArray &read);
+
+private:
+    static void CompareBytes(Comparison &comparison, const QByteArray &read, const QByteArray &expected, int address, char *checks);
+};
+//----------------------------------------------------------------------
+
+#endif // CHIPIMAGE_H
@@ -0,0 +1,15 @@
+# Links libeprom27, include from a project one level below the repo root
+QT += serialport
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+win32:CONFIG(release, debug|release): EPROM27_LIB_DIR = $$OUT_PWD/../core/release
+else:win32:CONFIG(debug, debug|release): EPROM27_LIB_DIR = $$OUT_PWD/../core/debug
+else: EPROM27_LIB_DIR = $$OUT_PWD/../core
+
+LIBS += -L$$EPROM27_LIB_DIR -leprom27
+
+win32-g++: PRE_TARGETDEPS += $$EPROM27_LIB_DIR/libeprom27.a
+else:win32: PRE_TARGETDEPS += $$EPROM27_LIB_DIR/eprom27.lib
+else: PRE_TARGETDEPS += $$EPROM27_LIB_DIR/libeprom27.a
@@ -0,0 +1,34 @@
+#-------------------------------------------------
+#
+# Protocol, chip and transfer code shared by the GUI and the command line
+#
+#-------------------------------------------------
+
+QT       += core serialport
+QT       -= gui
+
+TARGET = eprom27
+TEMPLATE = lib
+CONFIG += staticlib
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    arduino.cpp \
+    streamparser.cpp \
+    chipimage.cpp \
+    chipdatabase.cpp \
+    gangchannel.cpp \
+    gangprogrammer.cpp \
+    jobqueue.cpp \
+    eprommodel.cpp
+
+HEADERS += \
+    arduino.h \
+    streamparser.h \
+    chipimage.h \
+    chipdatabase.h \
+    gangchannel.h \
+    gangprogrammer.h \
+    jobqueue.h \
+    eprommodel.h
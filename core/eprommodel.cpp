@@ -0,0 +1,728 @@
+#include "eprommodel.h"
+#include <QFile>
+#include <cstring>
+//----------------------------------------------------------------------
+
+EpromModel::EpromModel(const QString &fileName, QObject *parent) :
+    QIODevice(parent),
+    fileName(fileName),
+    contents(SOCKET_SIZE, static_cast<char>(0xFF))
+{
+}
+//----------------------------------------------------------------------
+
+bool EpromModel::open(OpenMode mode)
+{
+    if(!fileName.isEmpty() && QFile::exists(fileName))
+    {
+        QFile file(fileName);
+        if(!file.open(QIODevice::ReadOnly))
+        {
+            setErrorString(QString("%1: %2").arg(fileName).arg(file.errorString()));
+            return false;
+        }
+        QByteArray data = file.readAll();
+        if(data.length() > SOCKET_SIZE)
+        {
+            setErrorString(QString("%1 holds more than a 27C080").arg(fileName));
+            return false;
+        }
+        SetContents(data);
+        savedLength = data.length();
+    }
+
+    // a fresh start, as the board resets when its port is opened
+    input.clear();
+    output = BANNER;
+    outputOffset = 0;
+    window = output.length();
+    sequence = 0;
+    chip = Arduino::NONE;
+    endAddress = 0;
+    wideAddresses = false;
+    compression = false;
+    blockLength = FRAME_BLOCK_LEN;
+    writing = false;
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+//----------------------------------------------------------------------
+
+void EpromModel::close(void)
+{
+    // the file keeps its length, or grows to the largest chip selected
+    if(isOpen() && !fileName.isEmpty() && savedLength)
+    {
+        QFile file(fileName);
+        if(file.open(QIODevice::WriteOnly)) {
+            file.write(contents.constData(), savedLength);
+        }
+    }
+    QIODevice::close();
+}
+//----------------------------------------------------------------------
+
+bool EpromModel::isSequential(void) const
+{
+    return true;
+}
+//----------------------------------------------------------------------
+
+qint64 EpromModel::bytesAvailable(void) const
+{
+    return window + QIODevice::bytesAvailable();
+}
+//----------------------------------------------------------------------
+
+bool EpromModel::waitForReadyRead(int msecs)
+{
+    // answers are ready as soon as the command is written, nothing to wait for
+    (void)msecs;
+    if(!window) {
+        window = qMin(CHUNK_LEN, output.length() - outputOffset);
+    }
+    return window > 0;
+}
+//----------------------------------------------------------------------
+
+const QByteArray &EpromModel::GetContents(void) const
+{
+    return contents;
+}
+//----------------------------------------------------------------------
+
+void EpromModel::SetContents(const QByteArray &data)
+{
+    contents = data.left(SOCKET_SIZE);
+    contents.append(SOCKET_SIZE - contents.length(), static_cast<char>(0xFF));
+}
+//----------------------------------------------------------------------
+
+void EpromModel::Erase(void)
+{
+    contents.fill(static_cast<char>(0xFF));
+}
+//----------------------------------------------------------------------
+
+void EpromModel::SetVoltage(double volts)
+{
+    voltage = qRound(volts * 100);
+}
+//----------------------------------------------------------------------
+
+void EpromModel::Clear(void)
+{
+    output.clear();
+    outputOffset = 0;
+    window = 0;
+}
+//----------------------------------------------------------------------
+
+qint64 EpromModel::readData(char *data, qint64 maxSize)
+{
+    int length = static_cast<int>(qMin<qint64>(maxSize, window));
+    memcpy(data, output.constData() + outputOffset, static_cast<size_t>(length));
+    outputOffset += length;
+    window -= length;
+
+    if(outputOffset == output.length()) {
+        Clear();
+    }
+    else if(!window) {
+        NotifyReader();
+    }
+    return length;
+}
+//----------------------------------------------------------------------
+
+qint64 EpromModel::writeData(const char *data, qint64 maxSize)
+{
+    input.append(data, static_cast<int>(maxSize));
+
+    // anything up to a sync byte is dropped, ASCII commands included
+    for(;;)
+    {
+        int start = input.indexOf(FRAME_SYNC);
+        if(start == -1)
+        {
+            input.clear();
+            break;
+        }
+        input.remove(0, start);
+
+        if(input.length() < FRAME_HEADER_LEN) {
+            break;
+        }
+        int length = static_cast<quint8>(input[3]);
+        if(length > FRAME_MAX_BLOCK_LEN)
+        {
+            input.clear();
+            SendError(Arduino::ERROR_CRC);
+            break;
+        }
+        if(input.length() < FRAME_HEADER_LEN + length + FRAME_CRC_LEN) {
+            break;
+        }
+
+        quint16 crc = static_cast<quint16>(static_cast<quint8>(input[FRAME_HEADER_LEN + length])
+                                           | (static_cast<quint8>(input[FRAME_HEADER_LEN + length + 1]) << 8));
+        if(crc != Arduino::Crc16(input.constData() + 1, FRAME_HEADER_LEN - 1 + length))
+        {
+            // the firmware drains the line after a bad frame
+            input.clear();
+            SendError(Arduino::ERROR_CRC);
+            break;
+        }
+
+        quint8 opcode = static_cast<quint8>(input[1]);
+        QByteArray payload = input.mid(FRAME_HEADER_LEN, length);
+        input.remove(0, FRAME_HEADER_LEN + length + FRAME_CRC_LEN);
+        HandleFrame(opcode, payload);
+    }
+
+    if(!window && outputOffset < output.length()) {
+        NotifyReader();
+    }
+    return maxSize;
+}
+//----------------------------------------------------------------------
+
+void EpromModel::NotifyReader(void)
+{
+    // queued, the reader is usually still in the call that wrote the command
+    if(readyReadPending) {
+        return;
+    }
+    readyReadPending = true;
+    QMetaObject::invokeMethod(this, "ReadyReadSlot", Qt::QueuedConnection);
+}
+//----------------------------------------------------------------------
+
+void EpromModel::ReadyReadSlot(void)
+{
+    readyReadPending = false;
+    if(!window) {
+        window = qMin(CHUNK_LEN, output.length() - outputOffset);
+    }
+    if(window) {
+        emit readyRead();
+    }
+}
+//----------------------------------------------------------------------
+
+void EpromModel::Send(quint8 opcode, const QByteArray &payload)
+{
+    QByteArray frame;
+    frame.append(FRAME_SYNC);
+    frame.append(static_cast<char>(opcode));
+    frame.append(static_cast<char>(sequence++));
+    frame.append(static_cast<char>(payload.length()));
+    frame.append(payload);
+
+    quint16 crc = Arduino::Crc16(frame.constData() + 1, frame.length() - 1);
+    frame.append(static_cast<char>(crc & 0xFF));
+    frame.append(static_cast<char>(crc >> 8));
+    output.append(frame);
+}
+//----------------------------------------------------------------------
+
+void EpromModel::SendError(quint8 code, const QByteArray &arguments)
+{
+    Send(Arduino::FRAME_ERROR, QByteArray(1, static_cast<char>(code)).append(arguments));
+}
+//----------------------------------------------------------------------
+
+void EpromModel::HandleFrame(quint8 opcode, const QByteArray &payload)
+{
+    const quint8 *data = reinterpret_cast<const quint8 *>(payload.constData());
+    int length = payload.length();
+
+    // a running write only takes its blocks, ABORT and STATUS
+    if(writing && opcode == Arduino::FRAME_DATA)
+    {
+        WriteBlock(payload);
+        return;
+    }
+    if(writing && opcode == Arduino::FRAME_DATA_RLE && compression)
+    {
+        // a broken block decodes to nothing and is refused by its length
+        QByteArray block;
+        if(!RleDecode(payload, block)) {
+            block.clear();
+        }
+        WriteBlock(block);
+        return;
+    }
+    if(writing && opcode == Arduino::FRAME_ABORT)
+    {
+        writing = false;
+        SendError(Arduino::ERROR_ABORTED, Address(writeAddress));
+        return;
+    }
+    if(writing && opcode != FRAME_STATUS_REQUEST)
+    {
+        SendError(Arduino::ERROR_BUSY);
+        return;
+    }
+
+    int first, last;
+    switch(opcode)
+    {
+        case Arduino::FRAME_HELLO:
+            {
+                wideAddresses = false;
+                compression = false;
+                blockLength = FRAME_BLOCK_LEN;
+                QByteArray info;
+                info.append(static_cast<char>(PROTOCOL_VERSION));
+                info.append(static_cast<char>(blockLength));
+                info.append(static_cast<char>(CAPABILITY_RLE | CAPABILITY_WIDE_ADDRESS));
+                info.append(static_cast<char>(FRAME_MAX_BLOCK_LEN));
+                Send(Arduino::FRAME_INFO, info);
+            }
+            break;
+        case Arduino::FRAME_OPTIONS:
+            if(length < 1 || length > 2 || (data[0] & ~(CAPABILITY_RLE | CAPABILITY_WIDE_ADDRESS))
+                    || (length == 2 && (data[1] < 16 || data[1] > FRAME_MAX_BLOCK_LEN || (data[1] & (data[1] - 1)))))
+            {
+                SendError(Arduino::ERROR_UNKNOWN_COMMAND);
+                break;
+            }
+            if(length == 2) {
+                blockLength = data[1];
+            }
+            wideAddresses = (data[0] & CAPABILITY_WIDE_ADDRESS) != 0;
+            compression = (data[0] & CAPABILITY_RLE) != 0;
+            if(chip > Arduino::C512 && !wideAddresses)
+            {
+                chip = Arduino::NONE;
+                endAddress = 0;
+            }
+            Send(Arduino::FRAME_OK);
+            break;
+        case Arduino::FRAME_SELECT:
+            if(length != 1 || data[0] > Arduino::C080)
+            {
+                SendError(Arduino::ERROR_UNKNOWN_COMMAND);
+                break;
+            }
+            if(data[0] > Arduino::C512 && !wideAddresses)
+            {
+                SendError(Arduino::ERROR_RANGE);
+                break;
+            }
+            chip = static_cast<Arduino::CHIP_TYPE>(data[0]);
+            endAddress = qMax(Arduino::ChipSize(chip) - 1, 0);
+            if(chip != Arduino::NONE) {
+                savedLength = qMax(savedLength, endAddress + 1);
+            }
+            Send(Arduino::FRAME_OK);
+            break;
+        case Arduino::FRAME_TIMING:
+            // every byte takes a single pulse here, the timing is only checked
+            if(length != 5 || !(data[0] | data[1]) || !data[2] || data[4] > 2) {
+                SendError(Arduino::ERROR_UNKNOWN_COMMAND);
+            }
+            else if(chip == Arduino::NONE) {
+                SendError(Arduino::ERROR_NO_CHIP);
+            }
+            else {
+                Send(Arduino::FRAME_OK);
+            }
+            break;
+        case Arduino::FRAME_VOLTAGE:
+            Send(Arduino::FRAME_VOLTAGE_INFO, Number(static_cast<quint32>(voltage)).left(2));
+            break;
+        case Arduino::FRAME_READ:
+            if(!ParseRange(payload, first, last)) {
+                break;
+            }
+            if(chip == Arduino::NONE)
+            {
+                SendError(Arduino::ERROR_NO_CHIP);
+                break;
+            }
+            Read(first, last);
+            break;
+        case Arduino::FRAME_WRITE:
+            if(!ParseRange(payload, first, last)) {
+                break;
+            }
+            if(chip == Arduino::NONE)
+            {
+                SendError(Arduino::ERROR_NO_CHIP);
+                break;
+            }
+            if(!CheckVoltage()) {
+                break;
+            }
+            writing = true;
+            writeAddress = first;
+            writeEnd = last;
+            pulseHistogram.fill(0, PULSE_HISTOGRAM_LEN);
+            Send(Arduino::FRAME_CREDIT, QByteArray(1, static_cast<char>(WRITE_WINDOW)));
+            break;
+        case Arduino::FRAME_BLANK:
+            if(chip == Arduino::NONE)
+            {
+                SendError(Arduino::ERROR_NO_CHIP);
+                break;
+            }
+            BlankCheck(length && data[0]);
+            break;
+        case Arduino::FRAME_CRC:
+            if(length != 1 || data[0] < 8 || data[0] > 12)
+            {
+                SendError(Arduino::ERROR_UNKNOWN_COMMAND);
+                break;
+            }
+            if(chip == Arduino::NONE)
+            {
+                SendError(Arduino::ERROR_NO_CHIP);
+                break;
+            }
+            CrcTable(data[0]);
+            break;
+        case Arduino::FRAME_READ_BYTES:
+        case Arduino::FRAME_WRITE_BYTES:
+            {
+                int entryLength = AddressLength() + (opcode == Arduino::FRAME_WRITE_BYTES ? 1 : 0);
+                if(!length || length % entryLength)
+                {
+                    SendError(Arduino::ERROR_UNKNOWN_COMMAND);
+                    break;
+                }
+                AccessBytes(opcode == Arduino::FRAME_WRITE_BYTES, payload);
+            }
+            break;
+        case Arduino::FRAME_ABORT:
+            // nothing running, an answer would be taken for the next command's
+            break;
+        default:
+            if(opcode == FRAME_STATUS_REQUEST)
+            {
+                QByteArray status(1, static_cast<char>(writing ? WRITE : WAIT));
+                status.append(Address(writing ? writeAddress : 0));
+                status.append(Address(writing ? writeEnd : 0));
+                Send(FRAME_STATUS_INFO, status);
+                break;
+            }
+            SendError(Arduino::ERROR_UNKNOWN_COMMAND);
+    }
+}
+//----------------------------------------------------------------------
+
+void EpromModel::WriteBlock(const QByteArray &data)
+{
+    int length = qMin(blockLength, writeEnd - writeAddress + 1);
+    if(data.length() != length)
+    {
+        writing = false;
+        SendError(Arduino::ERROR_BLOCK, QByteArray(1, static_cast<char>(data.length())).append(Address(writeAddress)));
+        return;
+    }
+
+    // matching bytes need no pulse, a bit that goes back to 1 needs an erase
+    int skipped = 0;
+    for(int i = 0; i < length; i++)
+    {
+        quint8 current = static_cast<quint8>(contents[writeAddress + i]);
+        quint8 wanted = static_cast<quint8>(data[i]);
+        if(current == wanted)
+        {
+            skipped++;
+            continue;
+        }
+        if((current & wanted) != wanted)
+        {
+            writing = false;
+            QByteArray arguments = Address(writeAddress + i);
+            arguments.append(static_cast<char>(wanted));
+            arguments.append(static_cast<char>(current));
+            SendError(Arduino::ERROR_NOT_ERASED, arguments);
+            return;
+        }
+    }
+    for(int i = 0; i < length; i++)
+    {
+        if(contents[writeAddress + i] != data[i])
+        {
+            contents[writeAddress + i] = data[i];
+            pulseHistogram[0]++;
+        }
+    }
+
+    writeAddress += length;
+    QByteArray acknowledge;
+    acknowledge.append(static_cast<char>(skipped));
+    acknowledge.append(static_cast<char>(length - skipped));
+    acknowledge.append(Address(writeAddress));
+    Send(Arduino::FRAME_OK, acknowledge);
+
+    if(writeAddress > writeEnd)
+    {
+        writing = false;
+        QByteArray histogram;
+        for(quint32 count : pulseHistogram) {
+            histogram.append(Number(count));
+        }
+        Send(Arduino::FRAME_PULSE_INFO, histogram);
+    }
+}
+//----------------------------------------------------------------------
+
+void EpromModel::Read(int first, int last)
+{
+    if(compression)
+    {
+        SendRle(contents.mid(first, last + 1 - first));
+        Send(Arduino::FRAME_OK);
+        return;
+    }
+    for(int address = first; address <= last; address += blockLength) {
+        Send(Arduino::FRAME_DATA, contents.mid(address, qMin(blockLength, last + 1 - address)));
+    }
+    Send(Arduino::FRAME_OK);
+}
+//----------------------------------------------------------------------
+
+void EpromModel::SendRle(const QByteArray &data)
+{
+    // the firmware's streaming encoder: runs of RLE_MIN_RUN and more become
+    // a run token, the rest goes out as literals, and a frame is sent
+    // whenever the next token would not fit into it
+    QByteArray frame;
+    QByteArray literals;
+    auto emitToken = [&](const QByteArray &token)
+    {
+        if(frame.length() + token.length() > FRAME_MAX_BLOCK_LEN)
+        {
+            Send(Arduino::FRAME_DATA_RLE, frame);
+            frame.clear();
+        }
+        frame.append(token);
+    };
+    auto emitLiterals = [&]()
+    {
+        if(!literals.isEmpty())
+        {
+            emitToken(QByteArray(1, static_cast<char>(literals.length() - 1)).append(literals));
+            literals.clear();
+        }
+    };
+
+    for(int i = 0; i < data.length(); )
+    {
+        int run = 1;
+        while(i + run < data.length() && run < RLE_MAX_RUN && data[i + run] == data[i]) {
+            run++;
+        }
+
+        if(run >= RLE_MIN_RUN)
+        {
+            emitLiterals();
+            emitToken(QByteArray(1, static_cast<char>(0x80 | (run - 1))).append(data[i]));
+        }
+        else
+        {
+            for(int j = 0; j < run; j++)
+            {
+                literals.append(data[i]);
+                if(literals.length() == RLE_MAX_LITERAL) {
+                    emitLiterals();
+                }
+            }
+        }
+        i += run;
+    }
+    emitLiterals();
+    if(!frame.isEmpty()) {
+        Send(Arduino::FRAME_DATA_RLE, frame);
+    }
+}
+//----------------------------------------------------------------------
+
+bool EpromModel::RleDecode(const QByteArray &input, QByteArray &output) const
+{
+    // the firmware decodes into its block buffer, more than that is an error
+    const quint8 *data = reinterpret_cast<const quint8 *>(input.constData());
+    int length = input.length();
+    for(int i = 0; i < length; )
+    {
+        quint8 token = data[i++];
+        int count = (token & 0x7F) + 1;
+        if(output.length() + count > FRAME_MAX_BLOCK_LEN) {
+            return false;
+        }
+
+        if(token & 0x80)
+        {
+            if(i >= length) {
+                return false;
+            }
+            output.append(count, static_cast<char>(data[i++]));
+        }
+        else
+        {
+            if(i + count > length) {
+                return false;
+            }
+            output.append(reinterpret_cast<const char *>(data + i), count);
+            i += count;
+        }
+    }
+    return true;
+}
+//----------------------------------------------------------------------
+
+void EpromModel::BlankCheck(bool earlyExit)
+{
+    // block by block like the firmware, an early exit finishes the block
+    int firstProgrammed = 0;
+    quint32 programmedBytes = 0, programmedBits = 0;
+    for(int address = 0; address <= endAddress && !(programmedBytes && earlyExit); address += FRAME_BLOCK_LEN)
+    {
+        for(int i = address; i < address + FRAME_BLOCK_LEN && i <= endAddress; i++)
+        {
+            quint8 programmed = static_cast<quint8>(~contents[i]);
+            if(!programmed) {
+                continue;
+            }
+            if(!programmedBytes) {
+                firstProgrammed = i;
+            }
+            programmedBytes++;
+            for(; programmed; programmed &= programmed - 1) {
+                programmedBits++;
+            }
+        }
+    }
+
+    QByteArray info(1, static_cast<char>(programmedBytes == 0));
+    info.append(Address(firstProgrammed));
+    info.append(Number(programmedBytes));
+    info.append(Number(programmedBits));
+    Send(Arduino::FRAME_BLANK_INFO, info);
+}
+//----------------------------------------------------------------------
+
+void EpromModel::CrcTable(int shift)
+{
+    int blockSize = 1 << shift;
+    QByteArray table;
+    for(int start = 0; start <= endAddress; start += blockSize)
+    {
+        table.append(Number(Arduino::Crc32(contents.constData() + start, qMin(blockSize, endAddress + 1 - start))));
+        if(table.length() == FRAME_MAX_BLOCK_LEN)
+        {
+            Send(Arduino::FRAME_CRC_TABLE, table);
+            table.clear();
+        }
+    }
+    if(!table.isEmpty()) {
+        Send(Arduino::FRAME_CRC_TABLE, table);
+    }
+    Send(Arduino::FRAME_OK);
+}
+//----------------------------------------------------------------------
+
+void EpromModel::AccessBytes(bool write, const QByteArray &payload)
+{
+    if(chip == Arduino::NONE)
+    {
+        SendError(Arduino::ERROR_NO_CHIP);
+        return;
+    }
+    if(write && !CheckVoltage()) {
+        return;
+    }
+
+    int entryLength = AddressLength() + (write ? 1 : 0);
+    QByteArray values;
+    for(int offset = 0; offset < payload.length(); offset += entryLength)
+    {
+        int address = AddressAt(payload, offset);
+        if(address > endAddress)
+        {
+            SendError(Arduino::ERROR_RANGE);
+            return;
+        }
+
+        quint8 current = static_cast<quint8>(contents[address]);
+        quint8 wanted = static_cast<quint8>(payload[offset + entryLength - 1]);
+        if(write && (current & wanted) != wanted)
+        {
+            QByteArray arguments = Address(address);
+            arguments.append(static_cast<char>(wanted));
+            arguments.append(static_cast<char>(current));
+            SendError(Arduino::ERROR_NOT_ERASED, arguments);
+            return;
+        }
+        if(write) {
+            contents[address] = static_cast<char>(wanted);
+        }
+        values.append(contents[address]);
+    }
+    Send(Arduino::FRAME_BYTES, values);
+}
+//----------------------------------------------------------------------
+
+bool EpromModel::ParseRange(const QByteArray &payload, int &first, int &last)
+{
+    int length = AddressLength();
+    first = 0;
+    last = endAddress;
+    if(payload.length() == length * 2)
+    {
+        first = AddressAt(payload, 0);
+        last = AddressAt(payload, length);
+    }
+    if((payload.length() != 0 && payload.length() != length * 2) || first > last || last > endAddress)
+    {
+        SendError(Arduino::ERROR_RANGE);
+        return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------
+
+bool EpromModel::CheckVoltage(void)
+{
+    if(voltage > 600) {
+        return true;
+    }
+    SendError(Arduino::ERROR_LOW_VOLTAGE, Number(static_cast<quint32>(voltage)).left(2));
+    return false;
+}
+//----------------------------------------------------------------------
+
+int EpromModel::AddressLength(void) const
+{
+    return wideAddresses ? 4 : 2;
+}
+//----------------------------------------------------------------------
+
+QByteArray EpromModel::Address(int address) const
+{
+    return Number(static_cast<quint32>(address)).left(AddressLength());
+}
+//----------------------------------------------------------------------
+
+int EpromModel::AddressAt(const QByteArray &payload, int offset) const
+{
+    int address = 0;
+    for(int i = AddressLength() - 1; i >= 0; i--) {
+        address = (address << 8) | static_cast<quint8>(payload[offset + i]);
+    }
+    return address;
+}
+//----------------------------------------------------------------------
+
+QByteArray EpromModel::Number(quint32 value)
+{
+    QByteArray number;
+    for(int i = 0; i < 4; i++, value >>= 8) {
+        number.append(static_cast<char>(value & 0xFF));
+    }
+    return number;
+}
+//----------------------------------------------------------------------
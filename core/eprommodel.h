@@ -0,0 +1,107 @@
+#ifndef EPROMMODEL_H
+#define EPROMMODEL_H
+//----------------------------------------------------------------------
+#include "arduino.h"
+#include <QIODevice>
+#include <QVector>
+//----------------------------------------------------------------------
+
+// A programmer with a chip in its socket, in software: answers the binary
+// protocol like the firmware built with the third address stage, RLE
+// included, so the whole host side runs without hardware. Programming only clears bits, an
+// erase sets the whole socket back to 0xFF. Each command is answered as soon
+// as it is written, a read or a check is done before ABORT can come in.
+// Backed by a file when given one: loaded on open, saved on close.
+class EpromModel : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit EpromModel(const QString &fileName = QString(), QObject *parent = nullptr);
+    bool open(OpenMode mode) override;
+    void close(void) override;
+    bool isSequential(void) const override;
+    qint64 bytesAvailable(void) const override;
+    bool waitForReadyRead(int msecs) override;
+
+    const QByteArray &GetContents(void) const;
+    void SetContents(const QByteArray &contents);
+    void Erase(void);
+    void SetVoltage(double volts);
+    void Clear(void); // drops unread answers, as QSerialPort::clear()
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    const char *BANNER = "Arduino 27CXXX EEPROM programmer\r\n";
+    const int PROTOCOL_VERSION = 13;
+    const int SOCKET_SIZE = 0x100000; // a 27C080 fills it
+    const char FRAME_SYNC = static_cast<char>(0xA5);
+    const int FRAME_HEADER_LEN = 4;
+    const int FRAME_CRC_LEN = 2;
+    const int FRAME_BLOCK_LEN = 64;
+    const int FRAME_MAX_BLOCK_LEN = 128;
+    const quint8 FRAME_STATUS_REQUEST = 0x0E;
+    const quint8 FRAME_STATUS_INFO = 0x4A;
+    const quint8 CAPABILITY_RLE = 0x01;
+    const quint8 CAPABILITY_WIDE_ADDRESS = 0x02;
+    const int RLE_MIN_RUN = 3;
+    const int RLE_MAX_RUN = 128;
+    const int RLE_MAX_LITERAL = 63;
+    const int WRITE_WINDOW = 2;
+    const int PULSE_HISTOGRAM_LEN = 8;
+    const int CHUNK_LEN = 4096; // handed out per readyRead, like serial port reads
+
+    enum COMMAND_MODE {
+        WAIT = 0,
+        WRITE = 2
+    };
+
+    QString fileName;
+    int savedLength = 0;
+    QByteArray contents;
+    QByteArray input;
+    QByteArray output;
+    int outputOffset = 0;
+    int window = 0; // bytes of output the reader may take
+    bool readyReadPending = false;
+    quint8 sequence = 0;
+
+    Arduino::CHIP_TYPE chip = Arduino::NONE;
+    int endAddress = 0;
+    bool wideAddresses = false;
+    bool compression = false;
+    int blockLength = 64;
+    int voltage = 1250; // 10 mV
+
+    bool writing = false;
+    int writeAddress = 0;
+    int writeEnd = 0;
+    QVector<quint32> pulseHistogram;
+
+    void NotifyReader(void);
+    void Send(quint8 opcode, const QByteArray &payload = QByteArray());
+    void SendError(quint8 code, const QByteArray &arguments = QByteArray());
+    void HandleFrame(quint8 opcode, const QByteArray &payload);
+    void WriteBlock(const QByteArray &data);
+    void Read(int first, int last);
+    void SendRle(const QByteArray &data);
+    bool RleDecode(const QByteArray &input, QByteArray &output) const;
+    void BlankCheck(bool earlyExit);
+    void CrcTable(int shift);
+    void AccessBytes(bool write, const QByteArray &payload);
+    bool ParseRange(const QByteArray &payload, int &first, int &last);
+    bool CheckVoltage(void);
+    int AddressLength(void) const;
+    QByteArray Address(int address) const;
+    int AddressAt(const QByteArray &payload, int offset) const;
+    static QByteArray Number(quint32 value);
+
+private slots:
+    void ReadyReadSlot(void);
+};
+//----------------------------------------------------------------------
+
+#endif // EPROMMODEL_H
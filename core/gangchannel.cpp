@@ -0,0 +1,242 @@
+#include "gangchannel.h"
+#include "chipimage.h"
+//----------------------------------------------------------------------
+
+GangChannel::GangChannel(int index, const QString &path, QObject *parent) :
+    QObject(parent),
+    index(index),
+    path(path),
+    arduino(new Arduino)
+{
+    arduino->moveToThread(&thread);
+
+    QObject::connect(arduino, SIGNAL(ConnectedSignal(bool, qint32)), this, SLOT(ConnectedSlot(bool, qint32)));
+    QObject::connect(arduino, SIGNAL(PortErrorSignal(QString)), this, SLOT(PortErrorSlot(QString)));
+    QObject::connect(arduino, SIGNAL(SerialOperationCompleteSignal()), this, SLOT(SerialOperationCompleteSlot()));
+    QObject::connect(arduino, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)), this, SLOT(ProgressSlot(quint32, quint32, quint32, qint32)));
+    QObject::connect(arduino, SIGNAL(ReadCompleteSignal()), this, SLOT(ReadCompleteSlot()));
+    QObject::connect(arduino, SIGNAL(WriteCompleteSignal()), this, SLOT(WriteCompleteSlot()));
+    QObject::connect(arduino, SIGNAL(WriteErrorSignal(quint32, QString)), this, SLOT(WriteErrorSlot(quint32, QString)));
+    QObject::connect(arduino, SIGNAL(BlankCheckSignal(bool, int, int, int)), this, SLOT(BlankCheckSlot(bool, int, int, int)));
+    QObject::connect(arduino, SIGNAL(ErrorSignal(QString)), this, SLOT(ErrorSlot(QString)));
+
+    timeoutTimer.setSingleShot(true);
+    timeoutTimer.setInterval(TIMEOUT);
+    QObject::connect(&timeoutTimer, SIGNAL(timeout()), this, SLOT(TimeoutSlot()));
+
+    thread.start();
+}
+//----------------------------------------------------------------------
+
+GangChannel::~GangChannel()
+{
+    // closed and deleted in its thread, after anything still queued there
+    QMetaObject::invokeMethod(arduino, "Close");
+    arduino->deleteLater();
+    thread.quit();
+    thread.wait();
+}
+//----------------------------------------------------------------------
+
+void GangChannel::Start(Arduino::CHIP_TYPE chip, const QString &part, OPERATION operation, const QByteArray &image)
+{
+    this->chip = chip;
+    this->part = part;
+    this->operation = operation;
+    this->image = image;
+
+    // the last rate that worked on this port goes first, as in the main window
+    QList<qint32> baudRates = Arduino::BaudRates(Arduino::SavedBaudRate(path));
+    SetState(CONNECTING, QString("Connecting"));
+    QMetaObject::invokeMethod(arduino, "Open", Q_ARG(QString, path), Q_ARG(QList<qint32>, baudRates));
+}
+//----------------------------------------------------------------------
+
+void GangChannel::Abort(void)
+{
+    switch(state)
+    {
+        case IDLE:
+        case FINISHED:
+            return;
+        case WRITING:
+        case VERIFYING:
+        case CHECKING:
+            // the running operation ends through its error path
+            QMetaObject::invokeMethod(arduino, "Abort");
+            return;
+        default:
+            Finish(false, QString("Aborted"));
+    }
+}
+//----------------------------------------------------------------------
+
+bool GangChannel::IsFinished(void) const
+{
+    return state == FINISHED;
+}
+//----------------------------------------------------------------------
+
+void GangChannel::SetState(STATE newState, const QString &text)
+{
+    state = newState;
+    timeoutTimer.start();
+    emit StateSignal(index, text);
+}
+//----------------------------------------------------------------------
+
+void GangChannel::ConnectedSlot(bool connected, qint32 baudRate)
+{
+    if(state != CONNECTING) {
+        return;
+    }
+    if(!connected)
+    {
+        Finish(false, QString("Programmer not found"));
+        return;
+    }
+    Arduino::SaveBaudRate(path, baudRate);
+
+    // Open() leaves a deselect running, the chip is selected after it
+    SetState(DESELECTING, QString("Connected"));
+}
+//----------------------------------------------------------------------
+
+void GangChannel::PortErrorSlot(QString message)
+{
+    Finish(false, message);
+}
+//----------------------------------------------------------------------
+
+void GangChannel::SerialOperationCompleteSlot(void)
+{
+    if(state == DESELECTING)
+    {
+        SetState(SELECTING, QString("Selecting chip"));
+        QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, chip), Q_ARG(QString, part));
+    }
+    else if(state == SELECTING) {
+        RunOperation();
+    }
+}
+//----------------------------------------------------------------------
+
+void GangChannel::RunOperation(void)
+{
+    switch(operation)
+    {
+        case WRITE:
+        case WRITE_VERIFY:
+            SetState(WRITING, QString("Writing"));
+            QMetaObject::invokeMethod(arduino, "WriteChip", Q_ARG(QByteArray, image));
+            break;
+        case VERIFY:
+            SetState(VERIFYING, QString("Verifying"));
+            QMetaObject::invokeMethod(arduino, "VerifyChip", Q_ARG(QByteArray, image));
+            break;
+        case BLANK:
+            // older firmware has no on-device scan, the read is checked here
+            SetState(CHECKING, QString("Blank check"));
+            if(arduino->HasBlankCheck()) {
+                QMetaObject::invokeMethod(arduino, "BlankCheck", Q_ARG(bool, false));
+            }
+            else {
+                QMetaObject::invokeMethod(arduino, "ReadChip");
+            }
+            break;
+    }
+}
+//----------------------------------------------------------------------
+
+void GangChannel::ProgressSlot(quint32 done, quint32 total, quint32 bytesPerSecond, qint32 remaining)
+{
+    timeoutTimer.start();
+    emit ProgressSignal(index, done, total, bytesPerSecond, remaining);
+}
+//----------------------------------------------------------------------
+
+void GangChannel::ReadCompleteSlot(void)
+{
+    if(state == CHECKING)
+    {
+        ChipImage::BlankCheck check = ChipImage::CheckBlank(*arduino->GetReadBuffer());
+        BlankCheckSlot(check.blank, check.firstProgrammed, check.programmedBytes, check.programmedBits);
+        return;
+    }
+    if(state != VERIFYING) {
+        return;
+    }
+
+    ChipImage::Comparison comparison = ChipImage::Compare(*arduino->GetReadBuffer(), image);
+    if(comparison.firstMismatch == -1)
+    {
+        Finish(true, operation == VERIFY ? QString("Verified") : QString("Written and verified"));
+        return;
+    }
+    Finish(false, QString("%1 errors, %2 warnings, first at 0x%3")
+           .arg(comparison.errors).arg(comparison.warnings).arg(comparison.firstMismatch, 0, 16));
+}
+//----------------------------------------------------------------------
+
+void GangChannel::WriteCompleteSlot(void)
+{
+    if(state != WRITING) {
+        return;
+    }
+    if(operation == WRITE)
+    {
+        Finish(true, QString("Written"));
+        return;
+    }
+
+    SetState(VERIFYING, QString("Verifying"));
+    QMetaObject::invokeMethod(arduino, "VerifyChip", Q_ARG(QByteArray, image));
+}
+//----------------------------------------------------------------------
+
+void GangChannel::WriteErrorSlot(quint32 address, QString message)
+{
+    Finish(false, QString("Write error for block 0x%1, %2").arg(address, 0, 16).arg(message));
+}
+//----------------------------------------------------------------------
+
+void GangChannel::BlankCheckSlot(bool blank, int firstProgrammed, int programmedBytes, int programmedBits)
+{
+    if(state != CHECKING) {
+        return;
+    }
+    if(blank)
+    {
+        Finish(true, QString("Blank"));
+        return;
+    }
+    Finish(false, QString("Not blank from 0x%1, %2 bytes / %3 bits programmed")
+           .arg(firstProgrammed, 0, 16).arg(programmedBytes).arg(programmedBits));
+}
+//----------------------------------------------------------------------
+
+void GangChannel::ErrorSlot(QString message)
+{
+    Finish(false, message);
+}
+//----------------------------------------------------------------------
+
+void GangChannel::TimeoutSlot(void)
+{
+    Finish(false, QString("Timed out"));
+}
+//----------------------------------------------------------------------
+
+void GangChannel::Finish(bool passed, const QString &message)
+{
+    if(state == FINISHED || state == IDLE) {
+        return;
+    }
+    state = FINISHED;
+    timeoutTimer.stop();
+
+    // the port is freed right away for the next batch
+    QMetaObject::invokeMethod(arduino, "Close");
+    emit FinishedSignal(index, passed, message);
+}
+//----------------------------------------------------------------------
@@ -0,0 +1,79 @@
+#ifndef GANGCHANNEL_H
+#define GANGCHANNEL_H
+//----------------------------------------------------------------------
+#include "arduino.h"
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+//----------------------------------------------------------------------
+
+// One programmer of a gang: its Arduino runs in a thread of its own, the
+// channel lives in the caller's thread and walks it through connect,
+// chip select and the job, reporting under its index
+class GangChannel : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum OPERATION {
+        WRITE,
+        WRITE_VERIFY,
+        VERIFY,
+        BLANK
+    };
+
+    GangChannel(int index, const QString &path, QObject *parent = nullptr);
+    ~GangChannel();
+    void Start(Arduino::CHIP_TYPE chip, const QString &part, OPERATION operation, const QByteArray &image);
+    void Abort(void);
+    bool IsFinished(void) const;
+
+signals:
+    void StateSignal(int, QString);
+    void ProgressSignal(int, quint32, quint32, quint32, qint32);
+    void FinishedSignal(int, bool, QString);
+
+private slots:
+    void ConnectedSlot(bool, qint32);
+    void PortErrorSlot(QString);
+    void SerialOperationCompleteSlot(void);
+    void ProgressSlot(quint32, quint32, quint32, qint32);
+    void ReadCompleteSlot(void);
+    void WriteCompleteSlot(void);
+    void WriteErrorSlot(quint32, QString);
+    void BlankCheckSlot(bool, int, int, int);
+    void ErrorSlot(QString);
+    void TimeoutSlot(void);
+
+private:
+    enum STATE {
+        IDLE,
+        CONNECTING,
+        DESELECTING,
+        SELECTING,
+        WRITING,
+        VERIFYING,
+        CHECKING,
+        FINISHED
+    };
+
+    const int TIMEOUT = 30000; // ms without progress before the device is failed
+
+    int index;
+    QString path;
+    QThread thread;
+    Arduino *arduino;
+    QTimer timeoutTimer;
+    STATE state = IDLE;
+    OPERATION operation = WRITE;
+    Arduino::CHIP_TYPE chip = Arduino::NONE;
+    QString part;
+    QByteArray image;
+
+    void SetState(STATE newState, const QString &text);
+    void RunOperation(void);
+    void Finish(bool passed, const QString &message);
+};
+//----------------------------------------------------------------------
+
+#endif // GANGCHANNEL_H
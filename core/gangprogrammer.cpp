@@ -0,0 +1,74 @@
+#include "gangprogrammer.h"
+//----------------------------------------------------------------------
+
+GangProgrammer::GangProgrammer(QObject *parent) :
+    QObject(parent)
+{
+}
+//----------------------------------------------------------------------
+
+GangProgrammer::~GangProgrammer()
+{
+    qDeleteAll(channels);
+}
+//----------------------------------------------------------------------
+
+void GangProgrammer::Start(const QStringList &paths, Arduino::CHIP_TYPE chip, const QString &part, GangChannel::OPERATION operation, const QByteArray &image)
+{
+    qDeleteAll(channels);
+    channels.clear();
+    passed = 0;
+    failed = 0;
+    timer.start();
+
+    for(int i = 0; i < paths.size(); i++)
+    {
+        GangChannel *channel = new GangChannel(i, paths[i]);
+        QObject::connect(channel, SIGNAL(StateSignal(int, QString)), this, SIGNAL(DeviceStateSignal(int, QString)));
+        QObject::connect(channel, SIGNAL(ProgressSignal(int, quint32, quint32, quint32, qint32)), this, SIGNAL(DeviceProgressSignal(int, quint32, quint32, quint32, qint32)));
+        QObject::connect(channel, SIGNAL(FinishedSignal(int, bool, QString)), this, SLOT(ChannelFinishedSlot(int, bool, QString)));
+        channels.append(channel);
+    }
+
+    // every channel connects in its own thread, they all start at once
+    for(GangChannel *channel : channels) {
+        channel->Start(chip, part, operation, image);
+    }
+}
+//----------------------------------------------------------------------
+
+void GangProgrammer::Abort(void)
+{
+    for(GangChannel *channel : channels) {
+        channel->Abort();
+    }
+}
+//----------------------------------------------------------------------
+
+bool GangProgrammer::IsRunning(void) const
+{
+    return passed + failed < channels.size();
+}
+//----------------------------------------------------------------------
+
+qint64 GangProgrammer::GetElapsed(void) const
+{
+    return timer.elapsed();
+}
+//----------------------------------------------------------------------
+
+void GangProgrammer::ChannelFinishedSlot(int index, bool devicePassed, QString message)
+{
+    if(devicePassed) {
+        passed++;
+    }
+    else {
+        failed++;
+    }
+    emit DeviceFinishedSignal(index, devicePassed, message);
+
+    if(!IsRunning()) {
+        emit FinishedSignal(passed, failed);
+    }
+}
+//----------------------------------------------------------------------
@@ -0,0 +1,40 @@
+#ifndef GANGPROGRAMMER_H
+#define GANGPROGRAMMER_H
+//----------------------------------------------------------------------
+#include "gangchannel.h"
+#include <QObject>
+#include <QElapsedTimer>
+//----------------------------------------------------------------------
+
+// Fans one job out to several programmers at once, each on its own
+// channel; devices are reported by their index in the port list
+class GangProgrammer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GangProgrammer(QObject *parent = nullptr);
+    ~GangProgrammer();
+    void Start(const QStringList &paths, Arduino::CHIP_TYPE chip, const QString &part, GangChannel::OPERATION operation, const QByteArray &image);
+    void Abort(void);
+    bool IsRunning(void) const;
+    qint64 GetElapsed(void) const;
+
+signals:
+    void DeviceStateSignal(int, QString);
+    void DeviceProgressSignal(int, quint32, quint32, quint32, qint32);
+    void DeviceFinishedSignal(int, bool, QString);
+    void FinishedSignal(int, int); // passed, failed
+
+private slots:
+    void ChannelFinishedSlot(int, bool, QString);
+
+private:
+    QList<GangChannel *> channels;
+    QElapsedTimer timer;
+    int passed = 0;
+    int failed = 0;
+};
+//----------------------------------------------------------------------
+
+#endif // GANGPROGRAMMER_H
@@ -0,0 +1,487 @@
+#include "jobqueue.h"
+#include "chipimage.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+//----------------------------------------------------------------------
+
+JobQueue::JobQueue(QObject *parent) :
+    QObject(parent)
+{
+}
+//----------------------------------------------------------------------
+
+void JobQueue::Append(const Job &job)
+{
+    jobs.append(job);
+}
+//----------------------------------------------------------------------
+
+void JobQueue::Remove(int index)
+{
+    if(index >= 0 && index < jobs.size()) {
+        jobs.removeAt(index);
+    }
+}
+//----------------------------------------------------------------------
+
+const QList<JobQueue::Job> &JobQueue::GetJobs(void) const
+{
+    return jobs;
+}
+//----------------------------------------------------------------------
+
+void JobQueue::Start(Arduino *arduino, Arduino::CHIP_TYPE selectedChip)
+{
+    this->arduino = arduino;
+    this->selectedChip = selectedChip;
+    selectedPart.clear();
+    records.clear();
+    jobIndex = 0;
+    chipIndex = 0;
+    passed = 0;
+    failed = 0;
+    aborting = false;
+    selectError.clear();
+    startStamp = QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
+    queueTimer.start();
+
+    // only held while the queue runs, the main window owns the programmer
+    serialOperationCompleteConnection = QObject::connect(arduino, SIGNAL(SerialOperationCompleteSignal()), this, SLOT(SerialOperationCompleteSlot()));
+    progressConnection = QObject::connect(arduino, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)), this, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)));
+    readCompleteConnection = QObject::connect(arduino, SIGNAL(ReadCompleteSignal()), this, SLOT(ReadCompleteSlot()));
+    writeCompleteConnection = QObject::connect(arduino, SIGNAL(WriteCompleteSignal()), this, SLOT(WriteCompleteSlot()));
+    writeErrorConnection = QObject::connect(arduino, SIGNAL(WriteErrorSignal(quint32, QString)), this, SLOT(WriteErrorSlot(quint32, QString)));
+    blankCheckConnection = QObject::connect(arduino, SIGNAL(BlankCheckSignal(bool, int, int, int)), this, SLOT(BlankCheckSlot(bool, int, int, int)));
+    errorConnection = QObject::connect(arduino, SIGNAL(ErrorSignal(QString)), this, SLOT(ErrorSlot(QString)));
+
+    NextChip();
+}
+//----------------------------------------------------------------------
+
+void JobQueue::ChipInserted(void)
+{
+    if(state != WAITING_CHIP) {
+        return;
+    }
+
+    record.swapTime = chipTimer.restart();
+    readBack = false;
+    step = 0;
+    RunStep();
+}
+//----------------------------------------------------------------------
+
+void JobQueue::Abort(void)
+{
+    switch(state)
+    {
+        case IDLE:
+            return;
+        case WAITING_CHIP:
+            aborting = true;
+            Finish();
+            return;
+        case SELECTING:
+            // the queue stops once the chip select is answered
+            aborting = true;
+            return;
+        case FINISHING_CHIP:
+            // FinishChip() stops the queue after the result went out
+            aborting = true;
+            return;
+        default:
+            // the running step ends through its error path
+            aborting = true;
+            QMetaObject::invokeMethod(arduino, "Abort");
+    }
+}
+//----------------------------------------------------------------------
+
+bool JobQueue::IsRunning(void) const
+{
+    return state != IDLE;
+}
+//----------------------------------------------------------------------
+
+Arduino::CHIP_TYPE JobQueue::GetSelectedChip(void) const
+{
+    return selectedChip;
+}
+//----------------------------------------------------------------------
+
+const QList<JobQueue::ChipRecord> &JobQueue::GetRecords(void) const
+{
+    return records;
+}
+//----------------------------------------------------------------------
+
+qint64 JobQueue::GetElapsed(void) const
+{
+    return IsRunning() ? queueTimer.elapsed() : elapsed;
+}
+//----------------------------------------------------------------------
+
+double JobQueue::ChipsPerHour(void) const
+{
+    // wall clock time, chip swaps are part of the throughput
+    qint64 ms = GetElapsed();
+    if(records.isEmpty() || ms <= 0) {
+        return 0;
+    }
+    return records.size() * 3600000.0 / ms;
+}
+//----------------------------------------------------------------------
+
+QString JobQueue::RecordsCsv(void) const
+{
+    auto field = [](qint64 ms) { return ms < 0 ? QString() : QString::number(ms); };
+
+    QString csv("job,image,part,chip,result,message,swap_ms,blank_ms,write_ms,verify_ms,archive_ms,busy_ms\n");
+    for(const ChipRecord &chipRecord : records)
+    {
+        QString message = chipRecord.message;
+        message.replace("\"", "\"\"");
+        csv.append(QString("%1,%2,%3,%4,%5,\"%6\",%7,%8,%9,%10,%11,%12\n")
+                   .arg(chipRecord.job + 1)
+                   .arg(QFileInfo(jobs.value(chipRecord.job).name).fileName())
+                   .arg(jobs.value(chipRecord.job).part)
+                   .arg(chipRecord.chip + 1)
+                   .arg(chipRecord.passed ? "pass" : "fail")
+                   .arg(message)
+                   .arg(chipRecord.swapTime)
+                   .arg(field(chipRecord.blankTime))
+                   .arg(field(chipRecord.writeTime))
+                   .arg(field(chipRecord.verifyTime))
+                   .arg(field(chipRecord.archiveTime))
+                   .arg(chipRecord.busyTime));
+    }
+    return csv;
+}
+//----------------------------------------------------------------------
+
+QString JobQueue::StepsText(int steps)
+{
+    QStringList names;
+    if(steps & STEP_BLANK) {
+        names.append("blank check");
+    }
+    if(steps & STEP_WRITE) {
+        names.append("write");
+    }
+    if(steps & STEP_VERIFY) {
+        names.append("verify");
+    }
+    if(steps & STEP_ARCHIVE) {
+        names.append("archive");
+    }
+
+    QString text = names.join(", ");
+    if(!text.isEmpty()) {
+        text[0] = text[0].toUpper();
+    }
+    return text;
+}
+//----------------------------------------------------------------------
+
+void JobQueue::NextChip(void)
+{
+    while(jobIndex < jobs.size() && chipIndex >= jobs[jobIndex].count)
+    {
+        jobIndex++;
+        chipIndex = 0;
+    }
+    if(jobIndex >= jobs.size())
+    {
+        Finish();
+        return;
+    }
+
+    // parts of one family differ in timing, they are selected as well
+    if(jobs[jobIndex].chip != selectedChip || jobs[jobIndex].part != selectedPart)
+    {
+        selectedChip = jobs[jobIndex].chip;
+        selectedPart = jobs[jobIndex].part;
+        state = SELECTING;
+        emit StateSignal(QString("Selecting %1").arg(selectedPart));
+        QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip), Q_ARG(QString, selectedPart));
+        return;
+    }
+    RequestChip();
+}
+//----------------------------------------------------------------------
+
+void JobQueue::RequestChip(void)
+{
+    state = WAITING_CHIP;
+    record = ChipRecord();
+    record.job = jobIndex;
+    record.chip = chipIndex;
+
+    // the swap time runs from here until the operator confirms
+    chipTimer.start();
+    emit StateSignal(QString("Waiting for chip %1 of %2").arg(chipIndex + 1).arg(jobs[jobIndex].count));
+    emit ChipRequestSignal(jobIndex, chipIndex);
+}
+//----------------------------------------------------------------------
+
+void JobQueue::SerialOperationCompleteSlot(void)
+{
+    if(state != SELECTING) {
+        return;
+    }
+    if(aborting || !selectError.isEmpty())
+    {
+        Finish();
+        return;
+    }
+    RequestChip();
+}
+//----------------------------------------------------------------------
+
+void JobQueue::RunStep(void)
+{
+    if(aborting)
+    {
+        FinishChip(false, QString("Aborted"));
+        return;
+    }
+
+    // steps always run in blank, write, verify, archive order
+    const Job &job = jobs[jobIndex];
+    do {
+        step = step ? step << 1 : STEP_BLANK;
+    } while(step <= STEP_ARCHIVE && !(job.steps & step));
+
+    if(step > STEP_ARCHIVE)
+    {
+        FinishChip(true, QString("Passed"));
+        return;
+    }
+
+    stepTimer.start();
+    switch(step)
+    {
+        case STEP_BLANK:
+            // older firmware has no on-device scan, the read is checked here
+            state = BLANK_CHECKING;
+            emit StateSignal(QString("Chip %1: blank check").arg(chipIndex + 1));
+            if(arduino->HasBlankCheck()) {
+                QMetaObject::invokeMethod(arduino, "BlankCheck", Q_ARG(bool, false));
+            }
+            else {
+                QMetaObject::invokeMethod(arduino, "ReadChip");
+            }
+            break;
+        case STEP_WRITE:
+            state = WRITING;
+            emit StateSignal(QString("Chip %1: writing").arg(chipIndex + 1));
+            QMetaObject::invokeMethod(arduino, "WriteChip", Q_ARG(QByteArray, job.image));
+            break;
+        case STEP_VERIFY:
+            state = VERIFYING;
+            emit StateSignal(QString("Chip %1: verifying").arg(chipIndex + 1));
+            QMetaObject::invokeMethod(arduino, "VerifyChip", Q_ARG(QByteArray, job.image));
+            break;
+        case STEP_ARCHIVE:
+            // a full verify read is reused, a second pass over the chip is skipped
+            state = ARCHIVING;
+            emit StateSignal(QString("Chip %1: archiving").arg(chipIndex + 1));
+            if(readBack) {
+                Archive();
+            }
+            else {
+                QMetaObject::invokeMethod(arduino, "ReadChip");
+            }
+            break;
+    }
+}
+//----------------------------------------------------------------------
+
+void JobQueue::EndStep(void)
+{
+    qint64 ms = stepTimer.elapsed();
+    switch(step)
+    {
+        case STEP_BLANK:
+            record.blankTime = ms;
+            break;
+        case STEP_WRITE:
+            record.writeTime = ms;
+            break;
+        case STEP_VERIFY:
+            record.verifyTime = ms;
+            break;
+        case STEP_ARCHIVE:
+            record.archiveTime = ms;
+            break;
+    }
+}
+//----------------------------------------------------------------------
+
+void JobQueue::ReadCompleteSlot(void)
+{
+    if(state == BLANK_CHECKING)
+    {
+        ChipImage::BlankCheck check = ChipImage::CheckBlank(*arduino->GetReadBuffer());
+        BlankCheckSlot(check.blank, check.firstProgrammed, check.programmedBytes, check.programmedBits);
+        return;
+    }
+    if(state == ARCHIVING)
+    {
+        Archive();
+        return;
+    }
+    if(state != VERIFYING) {
+        return;
+    }
+
+    EndStep();
+    ChipImage::Comparison comparison = ChipImage::Compare(*arduino->GetReadBuffer(), jobs[jobIndex].image);
+    if(comparison.firstMismatch != -1)
+    {
+        FinishChip(false, QString("%1 errors, %2 warnings, first at 0x%3")
+                   .arg(comparison.errors).arg(comparison.warnings).arg(comparison.firstMismatch, 0, 16));
+        return;
+    }
+    // a CRC verify fills the unchanged blocks from the image, it is no read back
+    readBack = !arduino->HasCrcVerify();
+    RunStep();
+}
+//----------------------------------------------------------------------
+
+void JobQueue::WriteCompleteSlot(void)
+{
+    if(state != WRITING) {
+        return;
+    }
+    EndStep();
+    RunStep();
+}
+//----------------------------------------------------------------------
+
+void JobQueue::WriteErrorSlot(quint32 address, QString message)
+{
+    if(state != WRITING) {
+        return;
+    }
+    EndStep();
+    FinishChip(false, QString("Write error for block 0x%1, %2").arg(address, 0, 16).arg(message));
+}
+//----------------------------------------------------------------------
+
+void JobQueue::BlankCheckSlot(bool blank, int firstProgrammed, int programmedBytes, int programmedBits)
+{
+    if(state != BLANK_CHECKING) {
+        return;
+    }
+    EndStep();
+    if(!blank)
+    {
+        FinishChip(false, QString("Not blank from 0x%1, %2 bytes / %3 bits programmed")
+                   .arg(firstProgrammed, 0, 16).arg(programmedBytes).arg(programmedBits));
+        return;
+    }
+    RunStep();
+}
+//----------------------------------------------------------------------
+
+void JobQueue::ErrorSlot(QString message)
+{
+    if(state == SELECTING)
+    {
+        // the programmer falls back to no chip, the queue stops once the select completes
+        selectedChip = Arduino::NONE;
+        selectedPart.clear();
+        selectError = message;
+        return;
+    }
+    if(state == IDLE || state == WAITING_CHIP || state == FINISHING_CHIP) {
+        return;
+    }
+    EndStep();
+    FinishChip(false, message);
+}
+//----------------------------------------------------------------------
+
+void JobQueue::Archive(void)
+{
+    // jobs of one run may share an image or a part, the job number tells them apart
+    const Job &job = jobs[jobIndex];
+    QString fileName = QDir(job.archivePath).filePath(QString("%1_%2_job%3_%4.bin")
+                                                      .arg(QFileInfo(job.name).completeBaseName())
+                                                      .arg(startStamp)
+                                                      .arg(jobIndex + 1)
+                                                      .arg(chipIndex + 1, 3, 10, QChar('0')));
+    if(QFile::exists(fileName))
+    {
+        EndStep();
+        FinishChip(false, QString("Archive %1 already exists").arg(QFileInfo(fileName).fileName()));
+        return;
+    }
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        EndStep();
+        FinishChip(false, QString("Unable to archive: %1").arg(file.errorString()));
+        return;
+    }
+    file.write(*arduino->GetReadBuffer());
+    file.close();
+
+    EndStep();
+    RunStep();
+}
+//----------------------------------------------------------------------
+
+void JobQueue::FinishChip(bool chipPassed, const QString &message)
+{
+    record.passed = chipPassed;
+    record.message = message;
+    record.busyTime = chipTimer.elapsed();
+    records.append(record);
+    if(chipPassed) {
+        passed++;
+    }
+    else {
+        failed++;
+    }
+
+    // an Abort() from a slot of the signal only sets aborting, it is handled below
+    state = FINISHING_CHIP;
+    emit ChipFinishedSignal(jobIndex, chipIndex, chipPassed, message);
+
+    chipIndex++;
+    if(aborting)
+    {
+        Finish();
+        return;
+    }
+    NextChip();
+}
+//----------------------------------------------------------------------
+
+void JobQueue::Finish(void)
+{
+    QObject::disconnect(serialOperationCompleteConnection);
+    QObject::disconnect(progressConnection);
+    QObject::disconnect(readCompleteConnection);
+    QObject::disconnect(writeCompleteConnection);
+    QObject::disconnect(writeErrorConnection);
+    QObject::disconnect(blankCheckConnection);
+    QObject::disconnect(errorConnection);
+
+    elapsed = queueTimer.elapsed();
+    state = IDLE;
+    if(!selectError.isEmpty()) {
+        emit StateSignal(selectError);
+    }
+    else {
+        emit StateSignal(aborting ? QString("Aborted") : QString("Finished"));
+    }
+    emit FinishedSignal(passed, failed);
+}
+//----------------------------------------------------------------------
@@ -0,0 +1,130 @@
+#ifndef JOBQUEUE_H
+#define JOBQUEUE_H
+//----------------------------------------------------------------------
+#include "arduino.h"
+#include <QObject>
+#include <QElapsedTimer>
+//----------------------------------------------------------------------
+
+// Runs a list of production jobs on one connected programmer: every chip
+// of a job goes through its steps back to back and the operator is only
+// asked in when the next chip has to go into the socket
+class JobQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum STEP {
+        STEP_BLANK = 0x01,
+        STEP_WRITE = 0x02,
+        STEP_VERIFY = 0x04,
+        STEP_ARCHIVE = 0x08
+    };
+
+    struct Job {
+        QString name;
+        QByteArray image;
+        Arduino::CHIP_TYPE chip = Arduino::NONE;
+        QString part; // chip database entry, it brings its own timing
+        int count = 1;
+        int steps = STEP_BLANK | STEP_WRITE | STEP_VERIFY;
+        QString archivePath; // directory for the read back images
+    };
+
+    // times in ms, -1 for a step the chip didn't get to
+    struct ChipRecord {
+        int job = 0;
+        int chip = 0;
+        bool passed = false;
+        QString message;
+        qint64 swapTime = 0;
+        qint64 blankTime = -1;
+        qint64 writeTime = -1;
+        qint64 verifyTime = -1;
+        qint64 archiveTime = -1;
+        qint64 busyTime = 0;
+    };
+
+    explicit JobQueue(QObject *parent = nullptr);
+    void Append(const Job &job);
+    void Remove(int index);
+    const QList<Job> &GetJobs(void) const;
+    void Start(Arduino *arduino, Arduino::CHIP_TYPE selectedChip);
+    void ChipInserted(void);
+    void Abort(void);
+    bool IsRunning(void) const;
+    Arduino::CHIP_TYPE GetSelectedChip(void) const;
+    const QList<ChipRecord> &GetRecords(void) const;
+    qint64 GetElapsed(void) const;
+    double ChipsPerHour(void) const;
+    QString RecordsCsv(void) const;
+    static QString StepsText(int steps);
+
+signals:
+    void StateSignal(QString);
+    void ProgressSignal(quint32, quint32, quint32, qint32);
+    void ChipRequestSignal(int, int); // job, chip
+    void ChipFinishedSignal(int, int, bool, QString);
+    void FinishedSignal(int, int); // passed, failed
+
+private slots:
+    void SerialOperationCompleteSlot(void);
+    void ReadCompleteSlot(void);
+    void WriteCompleteSlot(void);
+    void WriteErrorSlot(quint32, QString);
+    void BlankCheckSlot(bool, int, int, int);
+    void ErrorSlot(QString);
+
+private:
+    enum STATE {
+        IDLE,
+        SELECTING,
+        WAITING_CHIP,
+        FINISHING_CHIP, // while the chip's result is handed out
+        BLANK_CHECKING,
+        WRITING,
+        VERIFYING,
+        ARCHIVING
+    };
+
+    QList<Job> jobs;
+    QList<ChipRecord> records;
+    Arduino *arduino = nullptr;
+    Arduino::CHIP_TYPE selectedChip = Arduino::NONE;
+    QString selectedPart;
+    STATE state = IDLE;
+    int jobIndex = 0;
+    int chipIndex = 0;
+    int step = 0;
+    bool readBack = false;
+    bool aborting = false;
+    QString selectError;
+    int passed = 0;
+    int failed = 0;
+    qint64 elapsed = 0;
+    QString startStamp;
+    ChipRecord record;
+
+    QElapsedTimer queueTimer;
+    QElapsedTimer chipTimer;
+    QElapsedTimer stepTimer;
+
+    QMetaObject::Connection serialOperationCompleteConnection;
+    QMetaObject::Connection progressConnection;
+    QMetaObject::Connection readCompleteConnection;
+    QMetaObject::Connection writeCompleteConnection;
+    QMetaObject::Connection writeErrorConnection;
+    QMetaObject::Connection blankCheckConnection;
+    QMetaObject::Connection errorConnection;
+
+    void NextChip(void);
+    void RequestChip(void);
+    void RunStep(void);
+    void EndStep(void);
+    void Archive(void);
+    void FinishChip(bool chipPassed, const QString &message);
+    void Finish(void);
+};
+//----------------------------------------------------------------------
+
+#endif // JOBQUEUE_H
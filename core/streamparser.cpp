@@ -0,0 +1,234 @@
+#include "streamparser.h"
+#include <QElapsedTimer>
+#include <cstring>
+#include <random>
+//----------------------------------------------------------------------
+
+StreamParser::StreamParser(int capacity)
+{
+    // round up to a power of two so the indexes wrap with a mask
+    int size = 16;
+    while(size < capacity) {
+        size <<= 1;
+    }
+    ring.resize(size);
+    mask = size - 1;
+}
+//----------------------------------------------------------------------
+
+void StreamParser::Start(const QByteArray &header, char *payload, int payloadLength, const QByteArray &trailer)
+{
+    SetMarker(this->header, header);
+    SetMarker(this->trailer, trailer);
+    this->payload = payload;
+    this->payloadLength = payloadLength;
+    payloadReceived = 0;
+    head = 0;
+    count = 0;
+    direct = false;
+
+    if(!header.isEmpty()) {
+        state = HEADER;
+    }
+    else if(payloadLength > 0) {
+        state = PAYLOAD;
+    }
+    else {
+        state = trailer.isEmpty() ? DONE : TRAILER;
+    }
+}
+//----------------------------------------------------------------------
+
+// Where the next read should go and how much it may take: the rest of the
+// payload while the ring is empty, else the free run up to the ring's end.
+// Nothing is taken once the trailer is found, the bytes after it belong to
+// whoever reads next
+char *StreamParser::WritePointer(int &space)
+{
+    direct = (state == PAYLOAD && count == 0);
+    if(direct)
+    {
+        space = payloadLength - payloadReceived;
+        return payload + payloadReceived;
+    }
+
+    if(state == DONE)
+    {
+        space = 0;
+        return nullptr;
+    }
+
+    int tail = (head + count) & mask;
+    space = qMin(ring.size() - count, ring.size() - tail);
+    return ring.data() + tail;
+}
+//----------------------------------------------------------------------
+
+void StreamParser::Commit(int length)
+{
+    if(direct)
+    {
+        direct = false;
+        payloadReceived += length;
+        if(payloadReceived == payloadLength) {
+            state = trailer.text.isEmpty() ? DONE : TRAILER;
+        }
+        return;
+    }
+
+    count += length;
+    Parse();
+}
+//----------------------------------------------------------------------
+
+int StreamParser::Feed(const char *data, int length)
+{
+    int taken = 0;
+    while(taken < length)
+    {
+        int space;
+        char *destination = WritePointer(space);
+        if(space == 0) {
+            break;
+        }
+        int chunk = qMin(space, length - taken);
+        memcpy(destination, data + taken, static_cast<size_t>(chunk));
+        Commit(chunk);
+        taken += chunk;
+    }
+    return taken;
+}
+//----------------------------------------------------------------------
+
+StreamParser::STATE StreamParser::GetState(void) const
+{
+    return state;
+}
+//----------------------------------------------------------------------
+
+int StreamParser::GetPayloadReceived(void) const
+{
+    return payloadReceived;
+}
+//----------------------------------------------------------------------
+
+void StreamParser::SetMarker(Marker &marker, const QByteArray &text)
+{
+    // longest proper prefix that is also a suffix, so a mismatch resumes
+    // from a partial match instead of rescanning bytes already taken
+    marker.text = text;
+    marker.matched = 0;
+    marker.fallback.resize(text.length());
+    int length = 0;
+    for(int i = 0; i < text.length(); i++)
+    {
+        while(i > 0 && length > 0 && text[i] != text[length]) {
+            length = marker.fallback[length - 1];
+        }
+        if(i > 0 && text[i] == text[length]) {
+            length++;
+        }
+        marker.fallback[i] = length;
+    }
+}
+//----------------------------------------------------------------------
+
+bool StreamParser::MatchByte(Marker &marker, char c)
+{
+    const char *text = marker.text.constData();
+    while(marker.matched > 0 && text[marker.matched] != c) {
+        marker.matched = marker.fallback[marker.matched - 1];
+    }
+    if(text[marker.matched] == c) {
+        marker.matched++;
+    }
+    if(marker.matched == marker.text.length())
+    {
+        marker.matched = 0;
+        return true;
+    }
+    return false;
+}
+//----------------------------------------------------------------------
+
+void StreamParser::Parse(void)
+{
+    const char *data = ring.constData();
+    while(count > 0 && state != DONE)
+    {
+        if(state == PAYLOAD)
+        {
+            int length = qMin(qMin(count, ring.size() - head), payloadLength - payloadReceived);
+            memcpy(payload + payloadReceived, data + head, static_cast<size_t>(length));
+            payloadReceived += length;
+            head = (head + length) & mask;
+            count -= length;
+            if(payloadReceived == payloadLength) {
+                state = trailer.text.isEmpty() ? DONE : TRAILER;
+            }
+            continue;
+        }
+
+        char c = data[head];
+        head = (head + 1) & mask;
+        count--;
+        if(state == HEADER && MatchByte(header, c)) {
+            state = payloadLength > 0 ? PAYLOAD : (trailer.text.isEmpty() ? DONE : TRAILER);
+        }
+        else if(state == TRAILER && MatchByte(trailer, c)) {
+            state = DONE;
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+// Parses a 27C512 sized legacy read over and over, cut at random chunk
+// boundaries like serial port reads. Returns milliseconds per MB of
+// payload, or -1 if the payload didn't come out intact
+double StreamParser::Benchmark(int megabytes)
+{
+    const int imageLength = 0xFFFF + 1;
+    const QByteArray header("$#@!READ\r\n");
+    const QByteArray trailer("$#@!OK  \r\n");
+
+    std::mt19937 random(27);
+    QByteArray image(imageLength, 0);
+    for(int i = 0; i < imageLength; i++) {
+        image[i] = static_cast<char>(random());
+    }
+    QByteArray stream("$#@!OK  \r\n");
+    stream.append(header).append(image).append(trailer);
+
+    QVector<int> chunks;
+    std::uniform_int_distribution<int> chunkLength(1, 512);
+    for(int total = 0; total < stream.length(); total += chunks.last()) {
+        chunks.append(chunkLength(random));
+    }
+
+    QByteArray output(imageLength, 0);
+    StreamParser parser;
+    int rounds = megabytes * 1024 * 1024 / imageLength;
+    QElapsedTimer timer;
+    timer.start();
+    for(int round = 0; round < rounds; round++)
+    {
+        parser.Start(header, output.data(), imageLength, trailer);
+        int offset = 0;
+        for(int i = 0; i < chunks.length() && offset < stream.length(); i++)
+        {
+            int length = qMin(chunks[i], stream.length() - offset);
+            parser.Feed(stream.constData() + offset, length);
+            offset += length;
+        }
+        if(parser.GetState() != DONE) {
+            return -1;
+        }
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+
+    if(output != image) {
+        return -1;
+    }
+    return elapsed / 1e6 / (static_cast<double>(rounds) * imageLength / (1024 * 1024));
+}
+//----------------------------------------------------------------------
@@ -0,0 +1,60 @@
+#ifndef STREAMPARSER_H
+#define STREAMPARSER_H
+//----------------------------------------------------------------------
+#include <QByteArray>
+#include <QVector>
+//----------------------------------------------------------------------
+
+// Incremental parser for a header marker, a fixed length payload and a
+// trailer marker arriving in arbitrary chunks. Bytes are read into a
+// preallocated ring buffer, or straight into the payload while nothing
+// is buffered, so markers split across chunks are still found and the
+// payload is copied at most once
+class StreamParser
+{
+public:
+    enum STATE {
+        HEADER,
+        PAYLOAD,
+        TRAILER,
+        DONE
+    };
+
+    explicit StreamParser(int capacity = 1024);
+
+    void Start(const QByteArray &header, char *payload, int payloadLength, const QByteArray &trailer);
+    char *WritePointer(int &space);
+    void Commit(int length);
+    int Feed(const char *data, int length);
+    STATE GetState(void) const;
+    int GetPayloadReceived(void) const;
+
+    static double Benchmark(int megabytes);
+
+private:
+    struct Marker {
+        QByteArray text;
+        QVector<int> fallback;
+        int matched;
+    };
+
+    QByteArray ring;
+    int mask;
+    int head = 0;
+    int count = 0;
+    bool direct = false;
+
+    STATE state = DONE;
+    Marker header;
+    Marker trailer;
+    char *payload = nullptr;
+    int payloadLength = 0;
+    int payloadReceived = 0;
+
+    static void SetMarker(Marker &marker, const QByteArray &text);
+    static bool MatchByte(Marker &marker, char c);
+    void Parse(void);
+};
+//----------------------------------------------------------------------
+
+#endif // STREAMPARSER_H
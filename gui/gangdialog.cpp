@@ -0,0 +1,233 @@
+#include "gangdialog.h"
+#include "ui_gangdialog.h"
+#include "mainwindow.h"
+#include "chipdatabase.h"
+#include <QSerialPortInfo>
+#include <QMessageBox>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFile>
+#include <QProgressBar>
+#include <QTableWidgetItem>
+#include <QColor>
+//----------------------------------------------------------------------
+
+GangDialog::GangDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::GangDialog)
+{
+    ui->setupUi(this);
+
+    for(const ChipDatabase::Chip &chip : ChipDatabase::Instance().GetChips()) {
+        ui->chipCombo->addItem(chip.name, chip.name);
+    }
+
+    ui->operationCombo->addItem("Write and verify", GangChannel::WRITE_VERIFY);
+    ui->operationCombo->addItem("Write", GangChannel::WRITE);
+    ui->operationCombo->addItem("Verify", GangChannel::VERIFY);
+    ui->operationCombo->addItem("Blank check", GangChannel::BLANK);
+
+    ui->deviceTable->setColumnWidth(COLUMN_PORT, 70);
+    ui->deviceTable->setColumnWidth(COLUMN_STATUS, 110);
+    ui->deviceTable->setColumnWidth(COLUMN_PROGRESS, 120);
+
+    QObject::connect(&gang, SIGNAL(DeviceStateSignal(int, QString)), this, SLOT(DeviceStateSlot(int, QString)));
+    QObject::connect(&gang, SIGNAL(DeviceProgressSignal(int, quint32, quint32, quint32, qint32)), this, SLOT(DeviceProgressSlot(int, quint32, quint32, quint32, qint32)));
+    QObject::connect(&gang, SIGNAL(DeviceFinishedSignal(int, bool, QString)), this, SLOT(DeviceFinishedSlot(int, bool, QString)));
+    QObject::connect(&gang, SIGNAL(FinishedSignal(int, int)), this, SLOT(FinishedSlot(int, int)));
+
+    on_updateButton_clicked();
+    this->setFixedSize(size());
+}
+//----------------------------------------------------------------------
+
+GangDialog::~GangDialog()
+{
+    delete ui;
+}
+//----------------------------------------------------------------------
+
+void GangDialog::reject(void)
+{
+    // a batch is cancelled first, closing would leave chips half written
+    if(gang.IsRunning()) {
+        return;
+    }
+    QDialog::reject();
+}
+//----------------------------------------------------------------------
+
+Arduino::CHIP_TYPE GangDialog::SelectedChip(void)
+{
+    return ChipDatabase::Instance().Find(ui->chipCombo->currentData().toString())->type;
+}
+//----------------------------------------------------------------------
+
+QStringList GangDialog::CheckedPorts(void)
+{
+    QStringList paths;
+    for(int i = 0; i < ui->portList->count(); i++)
+    {
+        QListWidgetItem *item = ui->portList->item(i);
+        if(item->checkState() == Qt::Checked) {
+            paths.append(item->data(Qt::UserRole).toString());
+        }
+    }
+    return paths;
+}
+//----------------------------------------------------------------------
+
+void GangDialog::UpdateButtons(void)
+{
+    bool running = gang.IsRunning();
+    bool needsImage = ui->operationCombo->currentData().toInt() != GangChannel::BLANK;
+    int chipSize = Arduino::ChipSize(SelectedChip());
+
+    if(image.isEmpty()) {
+        ui->imageLabel->setText(QString("No image"));
+    }
+    else if(image.length() != chipSize) {
+        ui->imageLabel->setText(QString("%1: %2 bytes, chip holds %3").arg(imageName).arg(image.length()).arg(chipSize));
+    }
+    else {
+        ui->imageLabel->setText(QString("%1: %2 bytes").arg(imageName).arg(image.length()));
+    }
+
+    ui->jobGroup->setEnabled(!running);
+    ui->portsGroup->setEnabled(!running);
+    ui->startButton->setEnabled(!running && !CheckedPorts().isEmpty() && (!needsImage || image.length() == chipSize));
+    ui->cancelButton->setEnabled(running);
+    ui->closeButton->setEnabled(!running);
+}
+//----------------------------------------------------------------------
+
+void GangDialog::on_openImageButton_clicked(void)
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open image"), "", tr("Binary (*.bin *.rom);;All Files (*)"));
+    if(fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        QMessageBox::information(this, tr("Unable to open file"), file.errorString());
+        return;
+    }
+    image = file.readAll();
+    imageName = QFileInfo(fileName).fileName();
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void GangDialog::on_updateButton_clicked(void)
+{
+    ui->portList->clear();
+    const auto infos = QSerialPortInfo::availablePorts();
+    for(const QSerialPortInfo &info : infos)
+    {
+        QListWidgetItem *item = new QListWidgetItem(info.portName(), ui->portList);
+        item->setData(Qt::UserRole, info.systemLocation());
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Unchecked);
+        if(info.isBusy())
+        {
+            item->setText(info.portName() + " (Busy)");
+            item->setFlags(item->flags() & ~Qt::ItemIsEnabled);
+        }
+    }
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void GangDialog::on_chipCombo_currentIndexChanged(int index)
+{
+    (void)index;
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void GangDialog::on_operationCombo_currentIndexChanged(int index)
+{
+    (void)index;
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void GangDialog::on_portList_itemChanged(QListWidgetItem *item)
+{
+    (void)item;
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void GangDialog::on_startButton_clicked(void)
+{
+    QStringList paths = CheckedPorts();
+
+    ui->deviceTable->clearContents();
+    ui->deviceTable->setRowCount(paths.size());
+    for(int row = 0; row < paths.size(); row++)
+    {
+        ui->deviceTable->setItem(row, COLUMN_PORT, new QTableWidgetItem(QSerialPortInfo(paths[row]).portName()));
+        ui->deviceTable->setItem(row, COLUMN_STATUS, new QTableWidgetItem(QString("Waiting")));
+        ui->deviceTable->setItem(row, COLUMN_RESULT, new QTableWidgetItem());
+
+        QProgressBar *progressBar = new QProgressBar();
+        progressBar->setValue(0);
+        ui->deviceTable->setCellWidget(row, COLUMN_PROGRESS, progressBar);
+    }
+
+    ui->summaryLabel->setText(QString("Running %1 on %2 programmers...").arg(ui->operationCombo->currentText().toLower()).arg(paths.size()));
+    gang.Start(paths, SelectedChip(), ui->chipCombo->currentData().toString(), static_cast<GangChannel::OPERATION>(ui->operationCombo->currentData().toInt()), image);
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void GangDialog::on_cancelButton_clicked(void)
+{
+    ui->cancelButton->setEnabled(false);
+    ui->summaryLabel->setText(QString("Cancelling..."));
+    gang.Abort();
+}
+//----------------------------------------------------------------------
+
+void GangDialog::on_closeButton_clicked(void)
+{
+    reject();
+}
+//----------------------------------------------------------------------
+
+void GangDialog::DeviceStateSlot(int index, QString state)
+{
+    ui->deviceTable->item(index, COLUMN_STATUS)->setText(state);
+}
+//----------------------------------------------------------------------
+
+void GangDialog::DeviceProgressSlot(int index, quint32 done, quint32 total, quint32 bytesPerSecond, qint32 remaining)
+{
+    QProgressBar *progressBar = qobject_cast<QProgressBar *>(ui->deviceTable->cellWidget(index, COLUMN_PROGRESS));
+    progressBar->setMaximum(static_cast<int>(total));
+    progressBar->setValue(static_cast<int>(qMin(done, total)));
+    progressBar->setFormat(MainWindow::ProgressFormat(bytesPerSecond, remaining));
+}
+//----------------------------------------------------------------------
+
+void GangDialog::DeviceFinishedSlot(int index, bool passed, QString message)
+{
+    QTableWidgetItem *result = ui->deviceTable->item(index, COLUMN_RESULT);
+    result->setText(passed ? QString("Pass") : QString("Fail"));
+    result->setBackground(passed ? QColor(Qt::green) : QColor(Qt::red));
+    ui->deviceTable->item(index, COLUMN_STATUS)->setText(message);
+    ui->deviceTable->item(index, COLUMN_STATUS)->setToolTip(message);
+}
+//----------------------------------------------------------------------
+
+void GangDialog::FinishedSlot(int passed, int failed)
+{
+    int seconds = static_cast<int>((gang.GetElapsed() + 999) / 1000);
+    ui->summaryLabel->setText(QString("%1 passed, %2 failed in %3:%4")
+                              .arg(passed).arg(failed).arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0')));
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
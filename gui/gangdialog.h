@@ -0,0 +1,60 @@
+#ifndef GANGDIALOG_H
+#define GANGDIALOG_H
+//----------------------------------------------------------------------
+#include "gangprogrammer.h"
+#include <QDialog>
+#include <QListWidgetItem>
+//----------------------------------------------------------------------
+
+namespace Ui {
+class GangDialog;
+}
+//----------------------------------------------------------------------
+
+// Burns one image into a batch of chips, one programmer per checked port
+class GangDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit GangDialog(QWidget *parent = nullptr);
+    ~GangDialog();
+
+public slots:
+    void reject(void);
+
+private slots:
+    void on_openImageButton_clicked(void);
+    void on_updateButton_clicked(void);
+    void on_startButton_clicked(void);
+    void on_cancelButton_clicked(void);
+    void on_closeButton_clicked(void);
+    void on_chipCombo_currentIndexChanged(int);
+    void on_operationCombo_currentIndexChanged(int);
+    void on_portList_itemChanged(QListWidgetItem *);
+
+    void DeviceStateSlot(int, QString);
+    void DeviceProgressSlot(int, quint32, quint32, quint32, qint32);
+    void DeviceFinishedSlot(int, bool, QString);
+    void FinishedSlot(int, int);
+
+private:
+    enum COLUMN {
+        COLUMN_PORT,
+        COLUMN_STATUS,
+        COLUMN_PROGRESS,
+        COLUMN_RESULT
+    };
+
+    Ui::GangDialog *ui;
+    GangProgrammer gang;
+    QByteArray image;
+    QString imageName;
+
+    Arduino::CHIP_TYPE SelectedChip(void);
+    QStringList CheckedPorts(void);
+    void UpdateButtons(void);
+};
+//----------------------------------------------------------------------
+
+#endif // GANGDIALOG_H
@@ -27,14 +27,22 @@ DEFINES += QT_DEPRECATED_WARNINGS
 SOURCES += \
         main.cpp \
         mainwindow.cpp \
-    arduino.cpp
+    gangdialog.cpp \
+    jobdialog.cpp \
+    hexmodel.cpp
 
 HEADERS += \
         mainwindow.h \
-    arduino.h
+    gangdialog.h \
+    jobdialog.h \
+    hexmodel.h
+
+include(../core/core.pri)
 
 FORMS += \
-        mainwindow.ui
+        mainwindow.ui \
+    gangdialog.ui \
+    jobdialog.ui
 
 # Icon for Windows
 win32:RC_FILE = icon.rc
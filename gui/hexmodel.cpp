@@ -0,0 +1,90 @@
+#include "hexmodel.h"
+#include "chipimage.h"
+#include <QColor>
+//----------------------------------------------------------------------
+
+HexModel::HexModel(QObject *parent) :
+    QAbstractTableModel(parent),
+    font("Monospace", 9)
+{
+    font.setStyleHint(QFont::Monospace);
+    font.setWeight(QFont::Bold);
+}
+//----------------------------------------------------------------------
+
+void HexModel::SetContents(const QByteArray &contents, const QByteArray &checks)
+{
+    // both are shared with the caller, not copied
+    beginResetModel();
+    this->contents = contents;
+    this->checks = checks;
+    endResetModel();
+}
+//----------------------------------------------------------------------
+
+int HexModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : (contents.length() + 15) / 16;
+}
+//----------------------------------------------------------------------
+
+int HexModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+//----------------------------------------------------------------------
+
+QVariant HexModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.column() == COLUMN_SPACER) {
+        return QVariant();
+    }
+
+    bool hex = index.column() < COLUMN_SPACER;
+    int address = index.row() * 16 + (hex ? index.column() : index.column() - COLUMN_SPACER - 1);
+    if(address >= contents.length()) {
+        return QVariant();
+    }
+
+    switch(role)
+    {
+        case Qt::DisplayRole:
+            if(hex) {
+                return QString::asprintf("%02X", static_cast<uint8_t>(contents[address]));
+            }
+            return QString::asprintf("%c", static_cast<uint8_t>(contents[address]));
+        case Qt::FontRole:
+            return font;
+        case Qt::TextAlignmentRole:
+            return static_cast<int>(Qt::AlignHCenter | Qt::AlignVCenter);
+        case Qt::ForegroundRole:
+            if(hex && address < checks.length() && checks[address] == ChipImage::CHECK_ERROR_UNWRITABLE) {
+                return QColor::fromRgb(255, 0, 0);
+            }
+            if(hex && address < checks.length() && checks[address] == ChipImage::CHECK_ERROR_WRITABLE) {
+                return QColor::fromRgb(0, 0, 255);
+            }
+            return QColor::fromRgb(0, 0, 0);
+        default:
+            return QVariant();
+    }
+}
+//----------------------------------------------------------------------
+
+QVariant HexModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(role == Qt::FontRole) {
+        return font;
+    }
+    if(role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    if(orientation == Qt::Horizontal) {
+        return section < COLUMN_SPACER ? QString::asprintf("%02X", section) : QString();
+    }
+
+    // one more digit from the 27C010 on
+    return QString::asprintf(contents.length() > 0x10000 ? "%05X" : "%04X", section * 16);
+}
+//----------------------------------------------------------------------
@@ -0,0 +1,35 @@
+#ifndef HEXMODEL_H
+#define HEXMODEL_H
+//----------------------------------------------------------------------
+#include <QAbstractTableModel>
+#include <QByteArray>
+#include <QFont>
+//----------------------------------------------------------------------
+
+// Chip contents as 16 hex bytes and their characters per row. Cells are
+// only made for the rows on screen, a 27C080 has 65536 of them
+class HexModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum COLUMN {
+        COLUMN_SPACER = 16, // between the hex and the character columns
+        COLUMN_COUNT = 33
+    };
+
+    explicit HexModel(QObject *parent = nullptr);
+    void SetContents(const QByteArray &contents, const QByteArray &checks = QByteArray());
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    QByteArray contents;
+    QByteArray checks; // ChipImage::CHECK per byte, empty before a verify
+    QFont font;
+};
+//----------------------------------------------------------------------
+
+#endif // HEXMODEL_H
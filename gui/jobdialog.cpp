@@ -0,0 +1,356 @@
+#include "jobdialog.h"
+#include "ui_jobdialog.h"
+#include "mainwindow.h"
+#include "chipdatabase.h"
+#include <QApplication>
+#include <QMessageBox>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFile>
+#include <QTableWidgetItem>
+#include <QColor>
+//----------------------------------------------------------------------
+
+JobDialog::JobDialog(Arduino *arduino, Arduino::CHIP_TYPE selectedChip, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::JobDialog),
+    arduino(arduino),
+    selectedChip(selectedChip)
+{
+    ui->setupUi(this);
+
+    for(const ChipDatabase::Chip &chip : ChipDatabase::Instance().GetChips()) {
+        ui->chipCombo->addItem(chip.name, chip.name);
+    }
+    if(selectedChip != Arduino::NONE) {
+        ui->chipCombo->setCurrentIndex(ui->chipCombo->findData(ChipDatabase::Instance().Find(selectedChip)->name));
+    }
+
+    ui->jobTable->setColumnWidth(JOB_COLUMN_IMAGE, 110);
+    ui->jobTable->setColumnWidth(JOB_COLUMN_CHIP, 60);
+    ui->jobTable->setColumnWidth(JOB_COLUMN_COUNT, 50);
+    ui->recordTable->setColumnWidth(RECORD_COLUMN_JOB, 40);
+    ui->recordTable->setColumnWidth(RECORD_COLUMN_CHIP, 60);
+    ui->recordTable->setColumnWidth(RECORD_COLUMN_RESULT, 130);
+    ui->recordTable->setColumnWidth(RECORD_COLUMN_BUSY, 60);
+
+    QObject::connect(ui->chipCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(JobSettingsChangedSlot()));
+    QObject::connect(ui->blankCheck, SIGNAL(toggled(bool)), this, SLOT(JobSettingsChangedSlot()));
+    QObject::connect(ui->writeCheck, SIGNAL(toggled(bool)), this, SLOT(JobSettingsChangedSlot()));
+    QObject::connect(ui->verifyCheck, SIGNAL(toggled(bool)), this, SLOT(JobSettingsChangedSlot()));
+    QObject::connect(ui->archiveCheck, SIGNAL(toggled(bool)), this, SLOT(JobSettingsChangedSlot()));
+
+    QObject::connect(&queue, SIGNAL(StateSignal(QString)), this, SLOT(StateSlot(QString)));
+    QObject::connect(&queue, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)), this, SLOT(ProgressSlot(quint32, quint32, quint32, qint32)));
+    QObject::connect(&queue, SIGNAL(ChipRequestSignal(int, int)), this, SLOT(ChipRequestSlot(int, int)));
+    QObject::connect(&queue, SIGNAL(ChipFinishedSignal(int, int, bool, QString)), this, SLOT(ChipFinishedSlot(int, int, bool, QString)));
+    QObject::connect(&queue, SIGNAL(FinishedSignal(int, int)), this, SLOT(FinishedSlot(int, int)));
+
+    UpdateButtons();
+    this->setFixedSize(size());
+}
+//----------------------------------------------------------------------
+
+JobDialog::~JobDialog()
+{
+    delete ui;
+}
+//----------------------------------------------------------------------
+
+Arduino::CHIP_TYPE JobDialog::GetSelectedChip(void) const
+{
+    return selectedChip;
+}
+//----------------------------------------------------------------------
+
+void JobDialog::reject(void)
+{
+    // the queue is cancelled first, the programmer is still busy with it
+    if(queue.IsRunning()) {
+        return;
+    }
+    QDialog::reject();
+}
+//----------------------------------------------------------------------
+
+Arduino::CHIP_TYPE JobDialog::SelectedChip(void)
+{
+    return ChipDatabase::Instance().Find(ui->chipCombo->currentData().toString())->type;
+}
+//----------------------------------------------------------------------
+
+int JobDialog::SelectedSteps(void)
+{
+    int steps = 0;
+    if(ui->blankCheck->isChecked()) {
+        steps |= JobQueue::STEP_BLANK;
+    }
+    if(ui->writeCheck->isChecked()) {
+        steps |= JobQueue::STEP_WRITE;
+    }
+    if(ui->verifyCheck->isChecked()) {
+        steps |= JobQueue::STEP_VERIFY;
+    }
+    if(ui->archiveCheck->isChecked()) {
+        steps |= JobQueue::STEP_ARCHIVE;
+    }
+    return steps;
+}
+//----------------------------------------------------------------------
+
+void JobDialog::UpdateButtons(void)
+{
+    bool running = queue.IsRunning();
+    int steps = SelectedSteps();
+    int chipSize = Arduino::ChipSize(SelectedChip());
+    bool needsImage = steps & (JobQueue::STEP_WRITE | JobQueue::STEP_VERIFY);
+    bool needsArchive = steps & JobQueue::STEP_ARCHIVE;
+
+    if(image.isEmpty()) {
+        ui->imageLabel->setText(QString("No image"));
+    }
+    else if(image.length() != chipSize) {
+        ui->imageLabel->setText(QString("%1: %2 bytes, chip holds %3").arg(imageName).arg(image.length()).arg(chipSize));
+    }
+    else {
+        ui->imageLabel->setText(QString("%1: %2 bytes").arg(imageName).arg(image.length()));
+    }
+    ui->archiveButton->setToolTip(archivePath);
+
+    ui->jobGroup->setEnabled(!running);
+    ui->addButton->setEnabled(steps && (!needsImage || !image.isEmpty()) && (!needsArchive || !archivePath.isEmpty()));
+    ui->removeButton->setEnabled(!running && !ui->jobTable->selectedItems().isEmpty());
+    ui->startButton->setEnabled(!running && !queue.GetJobs().isEmpty());
+    ui->cancelButton->setEnabled(running);
+    ui->closeButton->setEnabled(!running);
+    ui->saveLogButton->setEnabled(!running && !queue.GetRecords().isEmpty());
+}
+//----------------------------------------------------------------------
+
+void JobDialog::ShowJobs(void)
+{
+    const QList<JobQueue::Job> &jobs = queue.GetJobs();
+    ui->jobTable->clearContents();
+    ui->jobTable->setRowCount(jobs.size());
+    for(int row = 0; row < jobs.size(); row++)
+    {
+        ui->jobTable->setItem(row, JOB_COLUMN_IMAGE, new QTableWidgetItem(jobs[row].name));
+        ui->jobTable->setItem(row, JOB_COLUMN_CHIP, new QTableWidgetItem(jobs[row].part));
+        ui->jobTable->setItem(row, JOB_COLUMN_COUNT, new QTableWidgetItem(QString::number(jobs[row].count)));
+        ui->jobTable->setItem(row, JOB_COLUMN_STEPS, new QTableWidgetItem(JobQueue::StepsText(jobs[row].steps)));
+    }
+}
+//----------------------------------------------------------------------
+
+void JobDialog::UpdateSummary(void)
+{
+    const QList<JobQueue::ChipRecord> &records = queue.GetRecords();
+    int passed = 0;
+    for(const JobQueue::ChipRecord &record : records)
+    {
+        if(record.passed) {
+            passed++;
+        }
+    }
+
+    int seconds = static_cast<int>((queue.GetElapsed() + 999) / 1000);
+    ui->summaryLabel->setText(QString("%1 passed, %2 failed in %3:%4, %5 chips/h")
+                              .arg(passed).arg(records.size() - passed)
+                              .arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'))
+                              .arg(queue.ChipsPerHour(), 0, 'f', 0));
+}
+//----------------------------------------------------------------------
+
+void JobDialog::JobSettingsChangedSlot(void)
+{
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::on_openImageButton_clicked(void)
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open image"), "", tr("Binary (*.bin *.rom);;All Files (*)"));
+    if(fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        QMessageBox::information(this, tr("Unable to open file"), file.errorString());
+        return;
+    }
+    image = file.readAll();
+    imageName = QFileInfo(fileName).fileName();
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::on_archiveButton_clicked(void)
+{
+    QString path = QFileDialog::getExistingDirectory(this, tr("Archive read back images to"), archivePath);
+    if(path.isEmpty()) {
+        return;
+    }
+    archivePath = path;
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::on_addButton_clicked(void)
+{
+    JobQueue::Job job;
+    job.chip = SelectedChip();
+    job.part = ui->chipCombo->currentData().toString();
+    job.count = ui->countSpin->value();
+    job.steps = SelectedSteps();
+    job.archivePath = archivePath;
+
+    // sized to the chip the same way the main window loads a file
+    int chipSize = Arduino::ChipSize(job.chip);
+    if(job.steps & (JobQueue::STEP_WRITE | JobQueue::STEP_VERIFY))
+    {
+        job.name = imageName;
+        job.image = image;
+        if(job.image.length() < chipSize) {
+            job.image.append(chipSize - job.image.length(), static_cast<char>(0xFF));
+        }
+        else {
+            job.image.resize(chipSize);
+        }
+    }
+    else {
+        job.name = job.part;
+    }
+
+    queue.Append(job);
+    ShowJobs();
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::on_removeButton_clicked(void)
+{
+    queue.Remove(ui->jobTable->currentRow());
+    ShowJobs();
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::on_jobTable_itemSelectionChanged(void)
+{
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::on_startButton_clicked(void)
+{
+    ui->recordTable->clearContents();
+    ui->recordTable->setRowCount(0);
+    ui->summaryLabel->clear();
+    ui->progressBar->setValue(0);
+
+    queue.Start(arduino, selectedChip);
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::on_insertedButton_clicked(void)
+{
+    ui->insertedButton->setEnabled(false);
+    ui->progressBar->setValue(0);
+    queue.ChipInserted();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::on_cancelButton_clicked(void)
+{
+    ui->cancelButton->setEnabled(false);
+    ui->insertedButton->setEnabled(false);
+    queue.Abort();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::on_closeButton_clicked(void)
+{
+    reject();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::on_saveLogButton_clicked(void)
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save chip log"), "", tr("CSV (*.csv);;All Files (*)"));
+    if(fileName.isEmpty()) {
+        return;
+    }
+    if(!fileName.endsWith(".csv", Qt::CaseInsensitive)) {
+        fileName.append(QString(".csv"));
+    }
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        QMessageBox::information(this, tr("Unable to open file"), file.errorString());
+        return;
+    }
+    file.write(queue.RecordsCsv().toUtf8());
+    file.close();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::StateSlot(QString state)
+{
+    // a chip select is sent to the programmer, the main window takes it over
+    selectedChip = queue.GetSelectedChip();
+    ui->promptLabel->setText(state);
+}
+//----------------------------------------------------------------------
+
+void JobDialog::ProgressSlot(quint32 done, quint32 total, quint32 bytesPerSecond, qint32 remaining)
+{
+    ui->progressBar->setMaximum(static_cast<int>(total));
+    ui->progressBar->setValue(static_cast<int>(qMin(done, total)));
+    ui->progressBar->setFormat(MainWindow::ProgressFormat(bytesPerSecond, remaining));
+}
+//----------------------------------------------------------------------
+
+void JobDialog::ChipRequestSlot(int job, int chip)
+{
+    const JobQueue::Job &request = queue.GetJobs().at(job);
+    ui->promptLabel->setText(QString("Insert %1 chip %2 of %3 for %4 and press Chip inserted.")
+                             .arg(request.part).arg(chip + 1).arg(request.count).arg(request.name));
+    ui->insertedButton->setEnabled(true);
+    ui->insertedButton->setFocus();
+    QApplication::beep();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::ChipFinishedSlot(int job, int chip, bool passed, QString message)
+{
+    const JobQueue::ChipRecord &record = queue.GetRecords().last();
+    int row = ui->recordTable->rowCount();
+    ui->recordTable->insertRow(row);
+    ui->recordTable->setItem(row, RECORD_COLUMN_JOB, new QTableWidgetItem(QString::number(job + 1)));
+    ui->recordTable->setItem(row, RECORD_COLUMN_CHIP, new QTableWidgetItem(QString("%1/%2").arg(chip + 1).arg(queue.GetJobs().at(job).count)));
+
+    QTableWidgetItem *result = new QTableWidgetItem(passed ? QString("Pass") : message);
+    result->setBackground(passed ? QColor(Qt::green) : QColor(Qt::red));
+    result->setToolTip(message);
+    ui->recordTable->setItem(row, RECORD_COLUMN_RESULT, result);
+    ui->recordTable->setItem(row, RECORD_COLUMN_BUSY, new QTableWidgetItem(QString("%1 s").arg(record.busyTime / 1000.0, 0, 'f', 1)));
+    ui->recordTable->setItem(row, RECORD_COLUMN_SWAP, new QTableWidgetItem(QString("%1 s").arg(record.swapTime / 1000.0, 0, 'f', 1)));
+    ui->recordTable->scrollToBottom();
+
+    UpdateSummary();
+}
+//----------------------------------------------------------------------
+
+void JobDialog::FinishedSlot(int passed, int failed)
+{
+    (void)passed;
+    (void)failed;
+    ui->insertedButton->setEnabled(false);
+    UpdateSummary();
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
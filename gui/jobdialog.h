@@ -0,0 +1,78 @@
+#ifndef JOBDIALOG_H
+#define JOBDIALOG_H
+//----------------------------------------------------------------------
+#include "jobqueue.h"
+#include <QDialog>
+//----------------------------------------------------------------------
+
+namespace Ui {
+class JobDialog;
+}
+//----------------------------------------------------------------------
+
+// Builds a queue of jobs and runs it on the connected programmer, the
+// operator only steps in to swap chips
+class JobDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    JobDialog(Arduino *arduino, Arduino::CHIP_TYPE selectedChip, QWidget *parent = nullptr);
+    ~JobDialog();
+    Arduino::CHIP_TYPE GetSelectedChip(void) const;
+
+public slots:
+    void reject(void);
+
+private slots:
+    void on_openImageButton_clicked(void);
+    void on_archiveButton_clicked(void);
+    void on_addButton_clicked(void);
+    void on_removeButton_clicked(void);
+    void on_startButton_clicked(void);
+    void on_insertedButton_clicked(void);
+    void on_cancelButton_clicked(void);
+    void on_closeButton_clicked(void);
+    void on_saveLogButton_clicked(void);
+    void on_jobTable_itemSelectionChanged(void);
+    void JobSettingsChangedSlot(void);
+
+    void StateSlot(QString);
+    void ProgressSlot(quint32, quint32, quint32, qint32);
+    void ChipRequestSlot(int, int);
+    void ChipFinishedSlot(int, int, bool, QString);
+    void FinishedSlot(int, int);
+
+private:
+    enum JOB_COLUMN {
+        JOB_COLUMN_IMAGE,
+        JOB_COLUMN_CHIP,
+        JOB_COLUMN_COUNT,
+        JOB_COLUMN_STEPS
+    };
+
+    enum RECORD_COLUMN {
+        RECORD_COLUMN_JOB,
+        RECORD_COLUMN_CHIP,
+        RECORD_COLUMN_RESULT,
+        RECORD_COLUMN_BUSY,
+        RECORD_COLUMN_SWAP
+    };
+
+    Ui::JobDialog *ui;
+    JobQueue queue;
+    Arduino *arduino;
+    Arduino::CHIP_TYPE selectedChip;
+    QByteArray image;
+    QString imageName;
+    QString archivePath;
+
+    Arduino::CHIP_TYPE SelectedChip(void);
+    int SelectedSteps(void);
+    void ShowJobs(void);
+    void UpdateSummary(void);
+    void UpdateButtons(void);
+};
+//----------------------------------------------------------------------
+
+#endif // JOBDIALOG_H
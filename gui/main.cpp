@@ -1,9 +1,35 @@
 #include "mainwindow.h"
+#include "streamparser.h"
+#include "chipdatabase.h"
 #include <QApplication>
+#include <QMessageBox>
+#include <QTextStream>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    a.setOrganizationName("arduino_eprom27_programmer");
+    a.setApplicationName("27_programmer");
+
+    // parser micro-benchmark, needs no programmer attached
+    if(a.arguments().contains("--bench-parser"))
+    {
+        double cost = StreamParser::Benchmark(64);
+        QTextStream out(stdout);
+        if(cost < 0) {
+            out << "Stream parser returned a corrupt image" << endl;
+            return 1;
+        }
+        out << QString("Stream parser: %1 ms/MB").arg(cost, 0, 'f', 3) << endl;
+        return 0;
+    }
+
+    // a broken chips.json leaves the built-in chips, the user is told why
+    QString error;
+    if(!ChipDatabase::Instance().LoadDefault(error)) {
+        QMessageBox::warning(nullptr, QString("Chip database"), error);
+    }
+
     MainWindow w;
     w.show();
 
@@ -1,6 +1,8 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
-#include <QSerialPort>
+#include "chipimage.h"
+#include "gangdialog.h"
+#include "jobdialog.h"
 #include <QSerialPortInfo>
 #include <QMessageBox>
 #include <QFileDialog>
@@ -11,10 +13,10 @@
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow),
-    serialPort(new QSerialPort) 
+    ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
+    ui->hexView->setModel(&hexModel);
     QIcon *mainIcon = GetGuiIcon();
     this->setWindowIcon(*mainIcon);
     delete mainIcon;
@@ -26,12 +28,22 @@ MainWindow::MainWindow(QWidget *parent) :
     updatePortsTimer.start();
     ReloadPortsSlot();
 
+    // serial I/O runs here, a busy GUI thread doesn't stall transfers
+    ioThread.start();
+
     this->setFixedSize(QSize(371, 431));
 }
 //----------------------------------------------------------------------
 
 MainWindow::~MainWindow()
 {
+    if(arduino)
+    {
+        QMetaObject::invokeMethod(arduino, "Close");
+        arduino->deleteLater();
+    }
+    ioThread.quit();
+    ioThread.wait();
     delete ui;
 }
 //----------------------------------------------------------------------
@@ -66,40 +78,68 @@ void MainWindow::Log(QString str)
 
 void MainWindow::OpenSerialPort(QString path)
 {
-    serialPort->setPortName(path);
-    serialPort->setBaudRate(QSerialPort::Baud115200);
+    arduino = new Arduino;
+    arduino->moveToThread(&ioThread);
+
+    logConnection = QObject::connect(arduino, SIGNAL(LogSignal(QString)), this, SLOT(Log(QString)));
+    connectedConnection = QObject::connect(arduino, SIGNAL(ConnectedSignal(bool, qint32)), this, SLOT(ConnectedSlot(bool, qint32)));
+    portErrorConnection = QObject::connect(arduino, SIGNAL(PortErrorSignal(QString)), this, SLOT(PortErrorSlot(QString)));
+    serialOperationStartConnection = QObject::connect(arduino, SIGNAL(SerialOperationStartSignal()), this, SLOT(UpdateCursorOnSerialOperationStartSlot()));
+    serialOperationCompleteConnection = QObject::connect(arduino, SIGNAL(SerialOperationCompleteSignal()), this, SLOT(UpdateCursorOnSerialOperationCompleteSlot()));
+    operationErrorConnection = QObject::connect(arduino, SIGNAL(ErrorSignal(QString)), this, SLOT(OperationErrorSlot(QString)));
+
+    // the last rate that worked on this port goes first
+    portPath = path;
+    QList<qint32> baudRates = Arduino::BaudRates(Arduino::SavedBaudRate(path));
+
+    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    QMetaObject::invokeMethod(arduino, "Open", Q_ARG(QString, path), Q_ARG(QList<qint32>, baudRates));
+}
+//----------------------------------------------------------------------
 
-    if(serialPort->open(QIODevice::ReadWrite))
+void MainWindow::ConnectedSlot(bool connected, qint32 baudRate)
+{
+    QApplication::restoreOverrideCursor();
+    if(!connected)
     {
-        QByteArray readData = serialPort->readAll();
-        while(serialPort->waitForReadyRead(5000))
-        {
-            readData.append(serialPort->readAll());
-            //Log(readData);
-            if(readData.indexOf(PROGRAMMER_NAME, 0) != -1)
-            {
-                Log(QString("Connect successful"));
+        CloseSerialPort();
+        return;
+    }
 
-                arduino = new Arduino(serialPort);
+    Arduino::SaveBaudRate(portPath, baudRate);
 
-                serialOperationStartConnection = QObject::connect(arduino, SIGNAL(SerialOperationStartSignal()), this, SLOT(UpdateCursorOnSerialOperationStartSlot()));
-                serialOperationCompleteConnection = QObject::connect(arduino, SIGNAL(SerialOperationCompleteSignal()), this, SLOT(UpdateCursorOnSerialOperationCompleteSlot()));
+    // the firmware starts with no chip selected
+    selectedChip = Arduino::NONE;
+    UpdateButtonsOnConnect();
+}
+//----------------------------------------------------------------------
 
-                selectedChip = Arduino::NONE;
-                arduino->SelectChip(selectedChip);
+void MainWindow::PortErrorSlot(QString message)
+{
+    QMessageBox::critical(this, tr("Error"), message);
+}
+//----------------------------------------------------------------------
 
-                UpdateButtonsOnConnect();
+void MainWindow::LogTransferStatistics(void)
+{
+    Arduino::TransferStatistics statistics = arduino->GetTransferStatistics();
+    double seconds = qMax<qint64>(statistics.elapsed, 1) / 1000.0;
+    double ratio = statistics.wireBytes ? static_cast<double>(statistics.dataBytes) / statistics.wireBytes : 1.0;
+
+    Log(QString("%1 bytes in %2 s, %3, compression ratio %4")
+        .arg(statistics.dataBytes)
+        .arg(seconds, 0, 'f', 2)
+        .arg(FormatRate(statistics.dataBytes / seconds))
+        .arg(ratio, 0, 'f', 2));
+}
+//----------------------------------------------------------------------
 
-                return;
-            }
-        }
-        Log(QString("Arduino programmer not found."));
-        CloseSerialPort();
-    } 
-    else 
-    {
-        QMessageBox::critical(this, tr("Error"), serialPort->errorString());
+QString MainWindow::FormatRate(double bytesPerSecond)
+{
+    if(bytesPerSecond >= 1024) {
+        return QString("%1 KB/s").arg(bytesPerSecond / 1024, 0, 'f', 1);
     }
+    return QString("%1 B/s").arg(qRound(bytesPerSecond));
 }
 //----------------------------------------------------------------------
 
@@ -118,13 +158,19 @@ void MainWindow::ResetAllButtons(void)
 {
     ui->connectButton->setEnabled(false);
     ui->updateButton->setEnabled(false);
+    ui->gangButton->setEnabled(true);
+    ui->jobButton->setEnabled(false);
     ui->disconnectButton->setEnabled(false);
     ui->voltageChipButton->setEnabled(false);
     ui->openFileButton->setEnabled(false);
     ui->saveFileButton->setEnabled(false);
     ui->readChipButton->setEnabled(false);
+    ui->blankCheckButton->setEnabled(false);
+    ui->benchmarkButton->setEnabled(false);
+    ui->cancelButton->setEnabled(false);
     ui->writeChipButton->setEnabled(false);
     ui->verifyChipButton->setEnabled(false);
+    EnableRangeWidgets(false);
 
     ui->showButton->setChecked(false);
     ui->showButton->setEnabled(false);
@@ -152,6 +198,22 @@ void MainWindow::ResetAllButtons(void)
     ui->c512Button->setEnabled(false);
     ui->c512Button->setAutoExclusive(false);
     ui->c512Button->setChecked(false);
+
+    ui->c010Button->setEnabled(false);
+    ui->c010Button->setAutoExclusive(false);
+    ui->c010Button->setChecked(false);
+
+    ui->c020Button->setEnabled(false);
+    ui->c020Button->setAutoExclusive(false);
+    ui->c020Button->setChecked(false);
+
+    ui->c040Button->setEnabled(false);
+    ui->c040Button->setAutoExclusive(false);
+    ui->c040Button->setChecked(false);
+
+    ui->c080Button->setEnabled(false);
+    ui->c080Button->setAutoExclusive(false);
+    ui->c080Button->setChecked(false);
 }
 //----------------------------------------------------------------------
 
@@ -161,6 +223,7 @@ void MainWindow::UpdateButtonsOnConnect(void)
     ui->disconnectButton->setEnabled(true);
     ui->connectButton->setEnabled(false);
     ui->voltageChipButton->setEnabled(true);
+    ui->jobButton->setEnabled(true);
 
     ui->c16Button->setEnabled(true);
     ui->c16Button->setAutoExclusive(true);
@@ -179,6 +242,18 @@ void MainWindow::UpdateButtonsOnConnect(void)
 
     ui->c512Button->setEnabled(true);
     ui->c512Button->setAutoExclusive(true);
+
+    ui->c010Button->setEnabled(true);
+    ui->c010Button->setAutoExclusive(true);
+
+    ui->c020Button->setEnabled(true);
+    ui->c020Button->setAutoExclusive(true);
+
+    ui->c040Button->setEnabled(true);
+    ui->c040Button->setAutoExclusive(true);
+
+    ui->c080Button->setEnabled(true);
+    ui->c080Button->setAutoExclusive(true);
 }
 //----------------------------------------------------------------------
 
@@ -192,9 +267,14 @@ void MainWindow::UpdateButtons(void)
     if(updateVoltageTimerConnection)
     {
         ui->disconnectButton->setEnabled(false);
+        ui->jobButton->setEnabled(false);
         ui->openFileButton->setEnabled(false);
         ui->saveFileButton->setEnabled(false);
         ui->readChipButton->setEnabled(false);
+        ui->blankCheckButton->setEnabled(false);
+        ui->benchmarkButton->setEnabled(false);
+        ui->cancelButton->setEnabled(false);
+        EnableRangeWidgets(false);
         ui->writeChipButton->setEnabled(false);
         ui->verifyChipButton->setEnabled(false);
         ui->showButton->setEnabled(false);
@@ -205,19 +285,31 @@ void MainWindow::UpdateButtons(void)
         ui->c128Button->setEnabled(false);
         ui->c256Button->setEnabled(false);
         ui->c512Button->setEnabled(false);
+        ui->c010Button->setEnabled(false);
+        ui->c020Button->setEnabled(false);
+        ui->c040Button->setEnabled(false);
+        ui->c080Button->setEnabled(false);
     }
     else
     {
         ui->disconnectButton->setEnabled(true);
+        ui->jobButton->setEnabled(true);
         ui->c16Button->setEnabled(true);
         ui->c32Button->setEnabled(true);
         ui->c64Button->setEnabled(true);
         ui->c128Button->setEnabled(true);
         ui->c256Button->setEnabled(true);
         ui->c512Button->setEnabled(true);
+        ui->c010Button->setEnabled(true);
+        ui->c020Button->setEnabled(true);
+        ui->c040Button->setEnabled(true);
+        ui->c080Button->setEnabled(true);
 
         ui->openFileButton->setEnabled(selectedChip != Arduino::NONE);
         ui->readChipButton->setEnabled(selectedChip != Arduino::NONE);
+        ui->blankCheckButton->setEnabled(selectedChip != Arduino::NONE);
+        ui->benchmarkButton->setEnabled(selectedChip != Arduino::NONE);
+        EnableRangeWidgets(selectedChip != Arduino::NONE);
 
         if(selectedChip != Arduino::NONE)
         {
@@ -248,16 +340,22 @@ void MainWindow::UpdateButtons(void)
                 ui->verifyChipButton->setEnabled(false);
             }
 
-            if(checkClearConnection || writeEndConnection || verifyDataWrittenConnection)
+            if(checkClearConnection || blankCheckConnection || benchmarkConnection || dumpRangeConnection || writeEndConnection
+                    || verifyDataWrittenConnection)
             {
                 ui->disconnectButton->setEnabled(false);
+                ui->jobButton->setEnabled(false);
                 ui->openFileButton->setEnabled(false);
                 ui->saveFileButton->setEnabled(false);
                 ui->readChipButton->setEnabled(false);
+                ui->blankCheckButton->setEnabled(false);
+                ui->benchmarkButton->setEnabled(false);
+                EnableRangeWidgets(false);
                 ui->writeChipButton->setEnabled(false);
                 ui->verifyChipButton->setEnabled(false);
                 ui->showButton->setEnabled(false);
                 ui->voltageChipButton->setEnabled(false);
+                ui->cancelButton->setEnabled(true);
 
                 ui->c16Button->setEnabled(false);
                 ui->c32Button->setEnabled(false);
@@ -265,10 +363,15 @@ void MainWindow::UpdateButtons(void)
                 ui->c128Button->setEnabled(false);
                 ui->c256Button->setEnabled(false);
                 ui->c512Button->setEnabled(false);
+                ui->c010Button->setEnabled(false);
+                ui->c020Button->setEnabled(false);
+                ui->c040Button->setEnabled(false);
+                ui->c080Button->setEnabled(false);
             }
             else
             {
                 ui->voltageChipButton->setEnabled(true);
+                ui->cancelButton->setEnabled(false);
             }
         }
         else
@@ -277,6 +380,7 @@ void MainWindow::UpdateButtons(void)
             ui->verifyChipButton->setEnabled(false);
             ui->saveFileButton->setEnabled(false);
             ui->showButton->setEnabled(false);
+            ui->cancelButton->setEnabled(false);
         }
 
     }
@@ -285,10 +389,17 @@ void MainWindow::UpdateButtons(void)
 
 void MainWindow::CloseSerialPort(void)
 {
+    QObject::disconnect(logConnection);
+    QObject::disconnect(connectedConnection);
+    QObject::disconnect(portErrorConnection);
     QObject::disconnect(serialOperationStartConnection);
     QObject::disconnect(serialOperationCompleteConnection);
+    QObject::disconnect(operationErrorConnection);
 
-    delete arduino;
+    // closed and deleted in the I/O thread, after anything still queued there
+    QMetaObject::invokeMethod(arduino, "Close");
+    arduino->deleteLater();
+    arduino = nullptr;
     selectedChip = Arduino::NONE;
     ResetAllButtons();
     ResetVaribles();
@@ -296,11 +407,7 @@ void MainWindow::CloseSerialPort(void)
     ui->portList->clear();
     updatePortsTimer.start();
 
-    if(serialPort->isOpen())
-    {
-        Log(QString("Disconnect..."));
-        serialPort->close();
-    }
+    Log(QString("Disconnect..."));
 }
 //----------------------------------------------------------------------
 
@@ -328,20 +435,34 @@ void MainWindow::CheckClearChipSlot(void)
     chipRead = true;
 
     UpdateButtons();
+    LogTransferStatistics();
 
-    uint8_t *dataRead = reinterpret_cast<uint8_t *>(arduino->GetReadBuffer()->data());
-    for(int i = 0, j = arduino->GetReadBuffer()->length(); i < j; i++)
+    if(!ChipImage::CheckBlank(*arduino->GetReadBuffer()).blank)
     {
-        if(dataRead[i] != 0xFF)
-        {
-            Log(QString("Chip not clear."));
-            return;
-        }
+        Log(QString("Chip not clear."));
+        return;
     }
     Log(QString("Chip clear."));
 }
 //----------------------------------------------------------------------
 
+void MainWindow::BlankCheckCompleteSlot(bool blank, int firstProgrammed, int programmedBytes, int programmedBits)
+{
+    QObject::disconnect(blankCheckConnection);
+
+    UpdateButtons();
+
+    qint64 elapsed = arduino->GetTransferStatistics().elapsed;
+    if(blank)
+    {
+        Log(QString("Chip clear (%1 ms).").arg(elapsed));
+        return;
+    }
+    Log(QString("Chip not clear, first programmed byte at 0x%1, %2 bytes / %3 bits programmed (%4 ms).")
+        .arg(firstProgrammed, selectedChip > Arduino::C512 ? 5 : 4, 16, QChar('0')).arg(programmedBytes).arg(programmedBits).arg(elapsed));
+}
+//----------------------------------------------------------------------
+
 void MainWindow::VerifyDataWrittenSlot(void)
 {
     QObject::disconnect(verifyDataWrittenConnection);
@@ -350,28 +471,11 @@ void MainWindow::VerifyDataWrittenSlot(void)
     chipVerified = true;
 
     UpdateButtons();
+    LogTransferStatistics();
 
-    checkBuffer.clear();
-    checkBuffer.resize(arduino->GetReadBuffer()->length());
-    checkBuffer.fill(CHECK_NO_ERROR);
-
-    uint8_t *dataRead = reinterpret_cast<uint8_t *>(arduino->GetReadBuffer()->data());
-    uint8_t *fileData = reinterpret_cast<uint8_t *>(fileLoadBuffer.data());
-
-    int errorsCount = 0, warningsCount = 0;
-    for(int i = 0, j = arduino->GetReadBuffer()->length(); i < j; i++)
-    {
-        if((dataRead[i] ^ fileData[i]) & fileData[i])
-        {
-            checkBuffer[i] = CHECK_ERROR_UNWRITABLE;
-            errorsCount++;
-        }
-        else if (dataRead[i] != fileData[i])
-        {
-            checkBuffer[i] = CHECK_ERROR_WRITABLE;
-            warningsCount++;
-        }
-    }
+    ChipImage::Comparison comparison = ChipImage::Compare(*arduino->GetReadBuffer(), fileLoadBuffer);
+    checkBuffer = comparison.checks;
+    int errorsCount = comparison.errors, warningsCount = comparison.warnings;
 
     if (errorsCount || warningsCount)
     {
@@ -392,89 +496,20 @@ void MainWindow::ShowBuffer(void)
         return;
     }
 
-    QTableWidget *tableWidget = ui->tableWidget;
-    QTableWidgetItem *newItem;
-
-    //Font
-    QFont font("Monospace", 9);
-    font.setStyleHint(QFont::Monospace);
-    font.setWeight(QFont::Bold);
-
-    tableWidget->setFixedWidth(700);
-
-    // clear table
-    tableWidget->setRowCount(0);
+    QTableView *hexView = ui->hexView;
+    hexView->setFixedWidth(700);
 
     // prepare layout
-    tableWidget->setStyleSheet("QTableWidget::item { padding: 0px, margin: 0px }");
-    tableWidget->horizontalHeader()->setVisible(true);
-    tableWidget->verticalHeader()->setVisible(true);
-    tableWidget->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-
-    // columns
-    tableWidget->setColumnCount(33);
-    for(int i = 0; i < 33; i++) {
-        tableWidget->setColumnWidth(i, 5);
-    }
-    // headers for hex data
-    for(int i = 0; i < 16; i++)
-    {
-        newItem = new QTableWidgetItem(tr("%1").arg(QString::asprintf("%02X", i)));
-        newItem->setFont(font);
-        tableWidget->setHorizontalHeaderItem(i, newItem);
-    }
-    // headers for other items
-    for(int i = 16; i < 33; i++)
-    {
-        newItem = new QTableWidgetItem(tr(""));
-        newItem->setFont(font);
-        tableWidget->setHorizontalHeaderItem(i, newItem);
-    }
-
-    // rows
-    tableWidget->setRowCount((arduino->GetChipSize() + 1) / 16);
-
-    for(int row = 0; row < tableWidget->rowCount(); ++row)
-    {
-        tableWidget->setRowHeight(row, 5);
-
-        // set row header
-        newItem = new QTableWidgetItem(tr("%1").arg(QString::asprintf("%04X", (row * 16))));
-        newItem->setFont(font);
-        tableWidget->setVerticalHeaderItem(row, newItem);
-
-        for(int column = 0; column < 16; ++column)
-        {
-            // hex data
-            newItem = new QTableWidgetItem(QString::asprintf("%02X", static_cast<uint8_t>(arduino->GetReadBuffer()->data()[row * 16 + column])));
-            newItem->setFont(font);
-            newItem->setTextAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
-
-            if(chipVerified)
-            {
-                if (checkBuffer.data()[row * 16 + column] == CHECK_ERROR_UNWRITABLE) {
-                    newItem->setForeground(QColor::fromRgb(255, 0, 0));
-                }
-                else if (checkBuffer.data()[row * 16 + column] == CHECK_ERROR_WRITABLE) {
-                    newItem->setForeground(QColor::fromRgb(0, 0, 255));
-                }
-                else {
-                    newItem->setForeground(QColor::fromRgb(0, 0, 0));
-                }
-            }
-            else {
-                newItem->setForeground(QColor::fromRgb(0, 0, 0));
-            }
-
-            tableWidget->setItem(row, column, newItem);
-
-            // char data
-            newItem = new QTableWidgetItem(QString::asprintf("%c", static_cast<uint8_t>(arduino->GetReadBuffer()->data()[row * 16 + column])));
-            newItem->setFont(font);
-            newItem->setTextAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
-            tableWidget->setItem(row, column + 17, newItem);
-        }
+    hexView->setStyleSheet("QTableView::item { padding: 0px, margin: 0px }");
+    hexView->horizontalHeader()->setVisible(true);
+    hexView->verticalHeader()->setVisible(true);
+    hexView->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+
+    hexModel.SetContents(*arduino->GetReadBuffer(), chipVerified ? checkBuffer : QByteArray());
+    for(int i = 0; i < HexModel::COLUMN_COUNT; i++) {
+        hexView->setColumnWidth(i, 5);
     }
+    hexView->verticalHeader()->setDefaultSectionSize(5);
 }
 //----------------------------------------------------------------------
 
@@ -486,10 +521,32 @@ void MainWindow::WriteCompleteAcknowledgeSlot(void)
     chipWritten = true;
 
     UpdateButtons();
+    LogTransferStatistics();
+
+    Arduino::TransferStatistics statistics = arduino->GetTransferStatistics();
+    if(statistics.skippedBytes || statistics.programmedBytes)
+    {
+        Log(QString("%1 bytes programmed, %2 already matching.")
+            .arg(statistics.programmedBytes).arg(statistics.skippedBytes));
+    }
+
+    if(!statistics.pulseHistogram.isEmpty())
+    {
+        QStringList bins;
+        for(int i = 0; i < statistics.pulseHistogram.size(); i++)
+        {
+            QString pulses = QString::number(i + 1);
+            if(i == statistics.pulseHistogram.size() - 1) {
+                pulses.append("+");
+            }
+            bins.append(QString("%1: %2").arg(pulses).arg(statistics.pulseHistogram[i]));
+        }
+        Log(QString("Bytes per pulse count: %1").arg(bins.join(", ")));
+    }
 }
 //----------------------------------------------------------------------
 
-void MainWindow::WriteCompleteErrorSlot(uint16_t address, char *message)
+void MainWindow::WriteCompleteErrorSlot(quint32 address, QString message)
 {
     QObject::disconnect(writeEndConnection);
     QObject::disconnect(progressBarConnection);
@@ -505,9 +562,47 @@ void MainWindow::WriteCompleteErrorSlot(uint16_t address, char *message)
 }
 //----------------------------------------------------------------------
 
-void MainWindow::ChipOperationProgressBarSlot(uint16_t value)
+void MainWindow::OperationErrorSlot(QString message)
+{
+    QObject::disconnect(checkClearConnection);
+    QObject::disconnect(blankCheckConnection);
+    QObject::disconnect(dumpRangeConnection);
+    QObject::disconnect(verifyDataWrittenConnection);
+    QObject::disconnect(progressBarConnection);
+    if(writeEndConnection)
+    {
+        // a refused range write or a cancelled write on older firmware
+        QObject::disconnect(writeEndConnection);
+        QObject::disconnect(writeErrorConnection);
+        chipWritten = false;
+    }
+    if(benchmarkConnection) {
+        FinishBenchmark();
+    }
+    UpdateButtons();
+
+    Log(QString("Error: %1").arg(message));
+}
+//----------------------------------------------------------------------
+
+void MainWindow::ChipOperationProgressBarSlot(quint32 done, quint32 total, quint32 bytesPerSecond, qint32 remaining)
 {
-    ui->progressBar->setValue(static_cast<int>(value));
+    ui->progressBar->setMaximum(static_cast<int>(total));
+    ui->progressBar->setValue(static_cast<int>(qMin(done, total)));
+
+    ui->progressBar->setFormat(ProgressFormat(bytesPerSecond, remaining));
+}
+//----------------------------------------------------------------------
+
+QString MainWindow::ProgressFormat(quint32 bytesPerSecond, qint32 remaining)
+{
+    QString format = QString("%p%  ") + FormatRate(bytesPerSecond);
+    if(remaining > 0)
+    {
+        int seconds = (remaining + 999) / 1000;
+        format.append(QString("  %1:%2 left").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0')));
+    }
+    return format;
 }
 //----------------------------------------------------------------------
 
@@ -531,7 +626,7 @@ void MainWindow::ShowVoltageSlot(void)
 {
     updateVoltageTimer.stop();
     updateVoltageValueConnection = QObject::connect(arduino, SIGNAL(VoltageUpdatedSignal(double)), this, SLOT(UpdateVoltageValueSlot(double)));
-    arduino->ReadVoltage();
+    QMetaObject::invokeMethod(arduino, "ReadVoltage");
 }
 //----------------------------------------------------------------------
 
@@ -569,15 +664,15 @@ void MainWindow::on_openFileButton_clicked(void)
 
         Log(QString("Load from %1 file").arg(fileName));
         Log(QString("Read %1 bytes").arg(fileLoadBuffer.count()));
-        if (fileLoadBuffer.count() < arduino->GetChipSize())
+        if (fileLoadBuffer.count() < Arduino::ChipSize(selectedChip))
         {
-            Log(QString("Padding by %1 bytes").arg(arduino->GetChipSize() - fileLoadBuffer.count()));
-            fileLoadBuffer.append((arduino->GetChipSize() - fileLoadBuffer.count()), static_cast<char>(0xFF));
+            Log(QString("Padding by %1 bytes").arg(Arduino::ChipSize(selectedChip) - fileLoadBuffer.count()));
+            fileLoadBuffer.append((Arduino::ChipSize(selectedChip) - fileLoadBuffer.count()), static_cast<char>(0xFF));
         }
-        else if(fileLoadBuffer.count() > arduino->GetChipSize())
+        else if(fileLoadBuffer.count() > Arduino::ChipSize(selectedChip))
         {
-            Log(QString("Deleted %1 bytes").arg(fileLoadBuffer.count() - arduino->GetChipSize()));
-            fileLoadBuffer.resize(arduino->GetChipSize());
+            Log(QString("Deleted %1 bytes").arg(fileLoadBuffer.count() - Arduino::ChipSize(selectedChip)));
+            fileLoadBuffer.resize(Arduino::ChipSize(selectedChip));
         }
         fileLoaded = true;
         ui->showButton->setChecked(false);
@@ -624,29 +719,35 @@ void MainWindow::on_writeChipButton_clicked(void)
         return;
     }
 
-    ui->progressBar->setMaximum(arduino->GetChipSize());
-    Log(QString("Writing %1 bytes to chip...").arg(arduino->GetChipSize()));
-    progressBarConnection = QObject::connect(arduino, SIGNAL(WriteBlockSignal(uint16_t)), this, SLOT(ChipOperationProgressBarSlot(uint16_t)));
+    int writeLength = arduino->GetWriteLength(fileLoadBuffer);
+    ui->progressBar->setMaximum(writeLength);
+    if(writeLength != Arduino::ChipSize(selectedChip)) {
+        Log(QString("Writing %1 non-blank bytes of %2 to chip...").arg(writeLength).arg(Arduino::ChipSize(selectedChip)));
+    }
+    else {
+        Log(QString("Writing %1 bytes to chip...").arg(writeLength));
+    }
+    progressBarConnection = QObject::connect(arduino, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)), this, SLOT(ChipOperationProgressBarSlot(quint32, quint32, quint32, qint32)));
     writeEndConnection = QObject::connect(arduino, SIGNAL(WriteCompleteSignal()), this, SLOT(WriteCompleteAcknowledgeSlot()));
-    writeErrorConnection = QObject::connect(arduino, SIGNAL(WriteErrorSignal(uint16_t, char*)), this, SLOT(WriteCompleteErrorSlot(uint16_t, char*)));
+    writeErrorConnection = QObject::connect(arduino, SIGNAL(WriteErrorSignal(quint32, QString)), this, SLOT(WriteCompleteErrorSlot(quint32, QString)));
     chipRead = false;
     chipWritten = false;
     chipVerified = false;
     UpdateButtons();
-    arduino->WriteChip(fileLoadBuffer);
+    QMetaObject::invokeMethod(arduino, "WriteChip", Q_ARG(QByteArray, fileLoadBuffer));
 }
 //----------------------------------------------------------------------
 
 void MainWindow::on_readChipButton_clicked(void)
 {
-    ui->progressBar->setMaximum(arduino->GetChipSize());
-    Log(QString("Reading %1 bytes from chip...").arg(arduino->GetChipSize()));
-    progressBarConnection = QObject::connect(arduino, SIGNAL(ReadBlockSignal(uint16_t)), this, SLOT(ChipOperationProgressBarSlot(uint16_t)));
+    ui->progressBar->setMaximum(Arduino::ChipSize(selectedChip));
+    Log(QString("Reading %1 bytes from chip...").arg(Arduino::ChipSize(selectedChip)));
+    progressBarConnection = QObject::connect(arduino, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)), this, SLOT(ChipOperationProgressBarSlot(quint32, quint32, quint32, qint32)));
     checkClearConnection = QObject::connect(arduino, SIGNAL(ReadCompleteSignal()), this, SLOT(CheckClearChipSlot()));
     chipRead = false;
     chipVerified = false;
     UpdateButtons();
-    arduino->ReadChip();
+    QMetaObject::invokeMethod(arduino, "ReadChip");
 }
 //----------------------------------------------------------------------
 
@@ -672,14 +773,285 @@ void MainWindow::on_portList_itemClicked(QListWidgetItem *item)
 
 void MainWindow::on_verifyChipButton_clicked(void)
 {
-    ui->progressBar->setMaximum(arduino->GetChipSize());
-    Log(QString("Verifying %1 bytes from chip...").arg(arduino->GetChipSize()));
-    progressBarConnection = QObject::connect(arduino, SIGNAL(ReadBlockSignal(uint16_t)), this, SLOT(ChipOperationProgressBarSlot(uint16_t)));
+    ui->progressBar->setMaximum(Arduino::ChipSize(selectedChip));
+    Log(QString("Verifying %1 bytes from chip...").arg(Arduino::ChipSize(selectedChip)));
+    progressBarConnection = QObject::connect(arduino, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)), this, SLOT(ChipOperationProgressBarSlot(quint32, quint32, quint32, qint32)));
     verifyDataWrittenConnection = QObject::connect(arduino, SIGNAL(ReadCompleteSignal()), this, SLOT(VerifyDataWrittenSlot()));
     chipRead = false;
     chipVerified = false;
     UpdateButtons();
-    arduino->ReadChip();
+    QMetaObject::invokeMethod(arduino, "VerifyChip", Q_ARG(QByteArray, fileLoadBuffer));
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_blankCheckButton_clicked(void)
+{
+    // older firmware has no on-device scan, read the whole chip instead
+    if(!arduino->HasBlankCheck())
+    {
+        on_readChipButton_clicked();
+        return;
+    }
+
+    Log(QString("Checking %1 bytes on chip...").arg(Arduino::ChipSize(selectedChip)));
+    blankCheckConnection = QObject::connect(arduino, SIGNAL(BlankCheckSignal(bool, int, int, int)), this, SLOT(BlankCheckCompleteSlot(bool, int, int, int)));
+    UpdateButtons();
+    QMetaObject::invokeMethod(arduino, "BlankCheck", Q_ARG(bool, false));
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_benchmarkButton_clicked(void)
+{
+    if(arduino->GetProtocolVersion() == 0)
+    {
+        Log(QString("Block size benchmark needs the binary protocol."));
+        return;
+    }
+
+    // frame lengths are 8 bits, 128 bytes is the largest power of two that fits
+    benchmarkBlockLengths.clear();
+    for(int length = 16; length <= arduino->GetMaxBlockLength(); length *= 2) {
+        benchmarkBlockLengths.append(length);
+    }
+
+    Log(QString("Reading %1 bytes per block size...").arg(Arduino::ChipSize(selectedChip)));
+    ui->progressBar->setMaximum(Arduino::ChipSize(selectedChip));
+    progressBarConnection = QObject::connect(arduino, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)), this, SLOT(ChipOperationProgressBarSlot(quint32, quint32, quint32, qint32)));
+    benchmarkConnection = QObject::connect(arduino, SIGNAL(ReadCompleteSignal()), this, SLOT(BenchmarkStepSlot()));
+    UpdateButtons();
+    BenchmarkNextSlot();
+}
+//----------------------------------------------------------------------
+
+void MainWindow::BenchmarkNextSlot(void)
+{
+    if(benchmarkBlockLengths.isEmpty())
+    {
+        FinishBenchmark();
+        UpdateButtons();
+        return;
+    }
+
+    QMetaObject::invokeMethod(arduino, "ReadChipBlocks", Q_ARG(int, benchmarkBlockLengths.takeFirst()));
+}
+//----------------------------------------------------------------------
+
+void MainWindow::BenchmarkStepSlot(void)
+{
+    Arduino::TransferStatistics statistics = arduino->GetTransferStatistics();
+    double seconds = qMax<qint64>(statistics.elapsed, 1) / 1000.0;
+    Log(QString("%1 B blocks: %2 bytes/s, %3 bytes on the wire")
+        .arg(arduino->GetBlockLength(), 3)
+        .arg(qRound(statistics.dataBytes / seconds))
+        .arg(statistics.wireBytes));
+
+    // the next size is set outside of the serial port signal handler
+    QTimer::singleShot(0, this, SLOT(BenchmarkNextSlot()));
+}
+//----------------------------------------------------------------------
+
+void MainWindow::FinishBenchmark(void)
+{
+    QObject::disconnect(benchmarkConnection);
+    QObject::disconnect(progressBarConnection);
+    benchmarkBlockLengths.clear();
+    QMetaObject::invokeMethod(arduino, "SetBlockLength", Q_ARG(int, arduino->GetMaxBlockLength()));
+    Log(QString("Block size %1 bytes").arg(arduino->GetMaxBlockLength()));
+}
+//----------------------------------------------------------------------
+
+void MainWindow::EnableRangeWidgets(bool enable)
+{
+    ui->rangeStartEdit->setEnabled(enable);
+    ui->rangeLengthEdit->setEnabled(enable);
+    ui->dumpRangeButton->setEnabled(enable);
+    ui->patchRangeButton->setEnabled(enable);
+}
+//----------------------------------------------------------------------
+
+bool MainWindow::GetRange(int &start, int &length)
+{
+    bool startValid = false, lengthValid = true;
+    start = ui->rangeStartEdit->text().toInt(&startValid, 16);
+    length = ui->rangeLengthEdit->text().isEmpty() ? Arduino::ChipSize(selectedChip) - start
+                                                   : ui->rangeLengthEdit->text().toInt(&lengthValid, 16);
+
+    if(!startValid || !lengthValid || start < 0 || length <= 0 || start + length > Arduino::ChipSize(selectedChip))
+    {
+        Log(QString("Invalid range, chip holds 0x%1 bytes.").arg(Arduino::ChipSize(selectedChip), 0, 16));
+        return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_dumpRangeButton_clicked(void)
+{
+    int start, length;
+    if(!GetRange(start, length)) {
+        return;
+    }
+
+    ui->progressBar->setMaximum(length);
+    progressBarConnection = QObject::connect(arduino, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)), this, SLOT(ChipOperationProgressBarSlot(quint32, quint32, quint32, qint32)));
+    dumpRangeConnection = QObject::connect(arduino, SIGNAL(ReadCompleteSignal()), this, SLOT(DumpRangeCompleteSlot()));
+
+    // the read buffer only holds the range from now on
+    Log(QString("Reading 0x%1 bytes from 0x%2...").arg(length, 0, 16).arg(start, 0, 16));
+    chipRead = false;
+    chipVerified = false;
+    UpdateButtons();
+    QMetaObject::invokeMethod(arduino, "ReadRange", Q_ARG(int, start), Q_ARG(int, length));
+}
+//----------------------------------------------------------------------
+
+void MainWindow::DumpRangeCompleteSlot(void)
+{
+    QObject::disconnect(dumpRangeConnection);
+    QObject::disconnect(progressBarConnection);
+
+    UpdateButtons();
+    LogTransferStatistics();
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save range"), "", tr("Binary (*.bin);;All Files (*)"));
+    if(fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        QMessageBox::information(this, tr("Unable to open file"), file.errorString());
+        return;
+    }
+
+    file.write(*arduino->GetReadBuffer());
+    file.close();
+    Log(QString("Range saved to %1 file").arg(fileName));
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_patchRangeButton_clicked(void)
+{
+    int start, length;
+    if(!GetRange(start, length)) {
+        return;
+    }
+
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Load patch"), "", tr("Binary (*.bin *.rom);;All Files (*)"));
+    if(fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        QMessageBox::information(this, tr("Unable to open file"), file.errorString());
+        return;
+    }
+    QByteArray data = file.read(length);
+    if(data.isEmpty())
+    {
+        Log(QString("%1 is empty").arg(fileName));
+        return;
+    }
+
+    ui->progressBar->setMaximum(data.length());
+    progressBarConnection = QObject::connect(arduino, SIGNAL(ProgressSignal(quint32, quint32, quint32, qint32)), this, SLOT(ChipOperationProgressBarSlot(quint32, quint32, quint32, qint32)));
+    writeEndConnection = QObject::connect(arduino, SIGNAL(WriteCompleteSignal()), this, SLOT(PatchRangeCompleteSlot()));
+    writeErrorConnection = QObject::connect(arduino, SIGNAL(WriteErrorSignal(quint32, QString)), this, SLOT(WriteCompleteErrorSlot(quint32, QString)));
+
+    Log(QString("Writing 0x%1 bytes from %2 at 0x%3...").arg(data.length(), 0, 16).arg(fileName).arg(start, 0, 16));
+    chipVerified = false;
+    UpdateButtons();
+    QMetaObject::invokeMethod(arduino, "WriteRange", Q_ARG(int, start), Q_ARG(QByteArray, data));
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_cancelButton_clicked(void)
+{
+    ui->cancelButton->setEnabled(false);
+    Log(QString("Cancelling..."));
+    QMetaObject::invokeMethod(arduino, "Abort");
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_gangButton_clicked(void)
+{
+    // the gang opens its own ports, the list is refreshed once it's done
+    updatePortsTimer.stop();
+    GangDialog dialog(this);
+    dialog.exec();
+    ReloadPortsSlot();
+    updatePortsTimer.start();
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_jobButton_clicked(void)
+{
+    JobDialog dialog(arduino, selectedChip, this);
+    dialog.exec();
+
+    // the queue may have selected another chip and left its last chip in the buffer
+    chipRead = false;
+    chipWritten = false;
+    chipVerified = false;
+    if(dialog.GetSelectedChip() != selectedChip)
+    {
+        fileLoaded = false;
+        selectedChip = dialog.GetSelectedChip();
+        switch(selectedChip)
+        {
+            case Arduino::C16:
+                ui->c16Button->setChecked(true);
+                break;
+            case Arduino::C32:
+                ui->c32Button->setChecked(true);
+                break;
+            case Arduino::C64:
+                ui->c64Button->setChecked(true);
+                break;
+            case Arduino::C128:
+                ui->c128Button->setChecked(true);
+                break;
+            case Arduino::C256:
+                ui->c256Button->setChecked(true);
+                break;
+            case Arduino::C512:
+                ui->c512Button->setChecked(true);
+                break;
+            case Arduino::C010:
+                ui->c010Button->setChecked(true);
+                break;
+            case Arduino::C020:
+                ui->c020Button->setChecked(true);
+                break;
+            case Arduino::C040:
+                ui->c040Button->setChecked(true);
+                break;
+            case Arduino::C080:
+                ui->c080Button->setChecked(true);
+                break;
+            default:
+                break;
+        }
+    }
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void MainWindow::PatchRangeCompleteSlot(void)
+{
+    QObject::disconnect(writeEndConnection);
+    QObject::disconnect(progressBarConnection);
+    QObject::disconnect(writeErrorConnection);
+
+    UpdateButtons();
+    LogTransferStatistics();
+
+    Arduino::TransferStatistics statistics = arduino->GetTransferStatistics();
+    Log(QString("%1 bytes programmed, %2 already matching.")
+        .arg(statistics.programmedBytes).arg(statistics.skippedBytes));
 }
 //----------------------------------------------------------------------
 
@@ -700,6 +1072,9 @@ void MainWindow::on_connectButton_clicked(void)
     }
 
     Log(QString("Connect to %1").arg(item->data(Qt::UserRole).toString()));
+    ui->connectButton->setEnabled(false);
+    ui->updateButton->setEnabled(false);
+    ui->gangButton->setEnabled(false);
     OpenSerialPort(item->data(Qt::UserRole).toString());
 }
 //----------------------------------------------------------------------
@@ -718,7 +1093,7 @@ void MainWindow::on_c16Button_clicked(void)
     fileLoaded = false;
     selectedChip = Arduino::C16;
     Log("Select 27C16 chip");
-    arduino->SelectChip(selectedChip);
+    QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip));
     UpdateButtons();
 }
 //----------------------------------------------------------------------
@@ -731,7 +1106,7 @@ void MainWindow::on_c32Button_clicked(void)
     fileLoaded = false;
     selectedChip = Arduino::C32;
     Log("Select 27C32 chip");
-    arduino->SelectChip(selectedChip);
+    QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip));
     UpdateButtons();
 }
 //----------------------------------------------------------------------
@@ -744,7 +1119,7 @@ void MainWindow::on_c64Button_clicked(void)
     fileLoaded = false;
     selectedChip = Arduino::C64;
     Log("Select 27C64 chip");
-    arduino->SelectChip(selectedChip);
+    QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip));
     UpdateButtons();
 }
 //----------------------------------------------------------------------
@@ -757,7 +1132,7 @@ void MainWindow::on_c128Button_clicked(void)
     fileLoaded = false;
     selectedChip = Arduino::C128;
     Log("Select 27C128 chip");
-    arduino->SelectChip(selectedChip);
+    QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip));
     UpdateButtons();
 }
 //----------------------------------------------------------------------
@@ -770,7 +1145,7 @@ void MainWindow::on_c256Button_clicked(void)
     fileLoaded = false;
     selectedChip = Arduino::C256;
     Log("Select 27C256 chip");
-    arduino->SelectChip(selectedChip);
+    QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip));
     UpdateButtons();
 }
 //----------------------------------------------------------------------
@@ -783,7 +1158,59 @@ void MainWindow::on_c512Button_clicked(void)
     fileLoaded = false;
     selectedChip = Arduino::C512;
     Log("Select 27C512 chip");
-    arduino->SelectChip(selectedChip);
+    QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip));
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_c010Button_clicked(void)
+{
+    chipRead = false;
+    chipWritten = false;
+    chipVerified = false;
+    fileLoaded = false;
+    selectedChip = Arduino::C010;
+    Log("Select 27C010 chip");
+    QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip));
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_c020Button_clicked(void)
+{
+    chipRead = false;
+    chipWritten = false;
+    chipVerified = false;
+    fileLoaded = false;
+    selectedChip = Arduino::C020;
+    Log("Select 27C020 chip");
+    QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip));
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_c040Button_clicked(void)
+{
+    chipRead = false;
+    chipWritten = false;
+    chipVerified = false;
+    fileLoaded = false;
+    selectedChip = Arduino::C040;
+    Log("Select 27C040 chip");
+    QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip));
+    UpdateButtons();
+}
+//----------------------------------------------------------------------
+
+void MainWindow::on_c080Button_clicked(void)
+{
+    chipRead = false;
+    chipWritten = false;
+    chipVerified = false;
+    fileLoaded = false;
+    selectedChip = Arduino::C080;
+    Log("Select 27C080 chip");
+    QMetaObject::invokeMethod(arduino, "SelectChip", Q_ARG(Arduino::CHIP_TYPE, selectedChip));
     UpdateButtons();
 }
 //----------------------------------------------------------------------
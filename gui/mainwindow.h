@@ -2,10 +2,11 @@
 #define MAINWINDOW_H
 //----------------------------------------------------------------------
 #include "arduino.h"
+#include "hexmodel.h"
 #include <QMainWindow>
-#include <QSerialPort>
 #include <QListWidgetItem>
 #include <QTimer>
+#include <QThread>
 //----------------------------------------------------------------------
 
 namespace Ui {
@@ -20,6 +21,8 @@ class MainWindow : public QMainWindow
 public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+    static QString FormatRate(double bytesPerSecond);
+    static QString ProgressFormat(quint32 bytesPerSecond, qint32 remaining);
 
 private slots:
 
@@ -28,12 +31,23 @@ private slots:
     void on_readChipButton_clicked(void);
     void on_writeChipButton_clicked(void);
     void on_verifyChipButton_clicked(void);
+    void on_blankCheckButton_clicked(void);
+    void on_benchmarkButton_clicked(void);
+    void on_dumpRangeButton_clicked(void);
+    void on_patchRangeButton_clicked(void);
+    void on_cancelButton_clicked(void);
+    void on_gangButton_clicked(void);
+    void on_jobButton_clicked(void);
     void on_c16Button_clicked(void);
     void on_c32Button_clicked(void);
     void on_c64Button_clicked(void);
     void on_c128Button_clicked(void);
     void on_c256Button_clicked(void);
     void on_c512Button_clicked(void);
+    void on_c010Button_clicked(void);
+    void on_c020Button_clicked(void);
+    void on_c040Button_clicked(void);
+    void on_c080Button_clicked(void);
     void on_connectButton_clicked(void);
     void on_disconnectButton_clicked(void);
     void on_updateButton_clicked(void);
@@ -41,26 +55,31 @@ private slots:
     void on_portList_itemClicked(QListWidgetItem *);
     void on_voltageChipButton_toggled(bool);
 
+    void ConnectedSlot(bool, qint32);
+    void PortErrorSlot(QString);
     void CheckClearChipSlot(void);
+    void BlankCheckCompleteSlot(bool, int, int, int);
+    void BenchmarkStepSlot(void);
+    void BenchmarkNextSlot(void);
+    void DumpRangeCompleteSlot(void);
+    void PatchRangeCompleteSlot(void);
     void VerifyDataWrittenSlot(void);
     void ReloadPortsSlot(void);
     void ShowVoltageSlot(void);
     void UpdateVoltageValueSlot(double);
-    void ChipOperationProgressBarSlot(uint16_t);
+    void ChipOperationProgressBarSlot(quint32, quint32, quint32, qint32);
     void WriteCompleteAcknowledgeSlot(void);
     void UpdateCursorOnSerialOperationStartSlot(void);
     void UpdateCursorOnSerialOperationCompleteSlot(void);
-    void WriteCompleteErrorSlot(uint16_t, char *);
+    void WriteCompleteErrorSlot(quint32, QString);
+    void OperationErrorSlot(QString);
+    void Log(QString str);
 
 private:
-    const char CHECK_NO_ERROR = 0;
-    const char CHECK_ERROR_WRITABLE = 1;
-    const char CHECK_ERROR_UNWRITABLE = 2;
-    const char *PROGRAMMER_NAME = "Arduino 27CXXX EEPROM programmer";
-
     Ui::MainWindow *ui;
-    QSerialPort *serialPort = nullptr;
+    QThread ioThread;
     Arduino *arduino = nullptr;
+    QString portPath;
 
     QTimer updatePortsTimer;
     QTimer updateVoltageTimer;
@@ -69,6 +88,9 @@ private:
     QMetaObject::Connection progressBarConnection;
     QMetaObject::Connection verifyDataWrittenConnection;
     QMetaObject::Connection checkClearConnection;
+    QMetaObject::Connection blankCheckConnection;
+    QMetaObject::Connection benchmarkConnection;
+    QMetaObject::Connection dumpRangeConnection;
     QMetaObject::Connection updateBufferConnection;
     QMetaObject::Connection updateVoltageTimerConnection;
     QMetaObject::Connection updateVoltageValueConnection;
@@ -76,9 +98,16 @@ private:
     QMetaObject::Connection writeErrorConnection;
     QMetaObject::Connection serialOperationStartConnection;
     QMetaObject::Connection serialOperationCompleteConnection;
+    QMetaObject::Connection operationErrorConnection;
+    QMetaObject::Connection logConnection;
+    QMetaObject::Connection connectedConnection;
+    QMetaObject::Connection portErrorConnection;
 
     Arduino::CHIP_TYPE selectedChip = Arduino::NONE;
 
+    QList<int> benchmarkBlockLengths;
+
+    HexModel hexModel;
     QByteArray checkBuffer;
     QByteArray fileLoadBuffer;
 
@@ -88,8 +117,11 @@ private:
     bool chipVerified = false;
 
     void ResetAllButtons(void);
-    void Log(QString str);
     void OpenSerialPort(QString);
+    void LogTransferStatistics(void);
+    void FinishBenchmark(void);
+    bool GetRange(int &start, int &length);
+    void EnableRangeWidgets(bool);
     void CloseSerialPort();
     void UpdateButtonsOnConnect(void);
     void ResetVaribles(void);
@@ -0,0 +1,185 @@
+#ifndef BUS_H
+#define BUS_H
+
+// Address and data bus of the programmer. Kept out of sketch.ino so that
+// host/ can build it against mocked registers and count what every byte costs.
+// Expects ADDRESS_SHIFT_STAGES, and ADDRESS_BUS_SPI when wanted, defined first.
+
+#if ADDRESS_SHIFT_STAGES != 2 && ADDRESS_SHIFT_STAGES != 3
+#error "ADDRESS_SHIFT_STAGES is 2, or 3 with the 32 pin adapter"
+#endif
+
+/* 74HC595 control (address lines) */
+#define SHIFT_LATCH_PIN A1
+#ifdef ADDRESS_BUS_SPI
+#define SHIFT_CLOCK_PIN 13 // SCK
+#define SHIFT_DATA_PIN  11 // MOSI
+#else
+#define SHIFT_CLOCK_PIN A2
+#define SHIFT_DATA_PIN  A0
+#endif
+#define ADDRESS_A10_PIN 13
+
+/* Address bus port layout (ATmega328P/168): latch on PC1, clock on PC2, data on PC0 */
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+#define FAST_ADDRESS_BUS
+#define SHIFT_LATCH_BIT 1
+#define SHIFT_CLOCK_BIT 2
+#define SHIFT_DATA_BIT  0
+#endif
+
+#if defined(ADDRESS_BUS_SPI) && !defined(FAST_ADDRESS_BUS)
+#error "ADDRESS_BUS_SPI is only supported on ATmega328P/168"
+#endif
+
+/* Data pins */
+#define DATA_B0_PIN 2
+#define DATA_B1_PIN 3
+#define DATA_B2_PIN 4
+#define DATA_B3_PIN 5
+#define DATA_B4_PIN 6
+#define DATA_B5_PIN 7
+#define DATA_B6_PIN 8
+#define DATA_B7_PIN 10
+
+/* Data bus port layout (ATmega328P/168): B0..B5 on PD2..PD7, B6 on PB0, B7 on PB2 */
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+#if DATA_B0_PIN == 2 && DATA_B1_PIN == 3 && DATA_B2_PIN == 4 && DATA_B3_PIN == 5 && \
+    DATA_B4_PIN == 6 && DATA_B5_PIN == 7 && DATA_B6_PIN == 8 && DATA_B7_PIN == 10
+#define FAST_DATA_BUS
+#define DATA_PORTD_MASK 0xFC
+#define DATA_PORTB_MASK 0x05
+#endif
+#endif
+
+void SetWriteMode(void)
+{
+#ifdef FAST_DATA_BUS
+  DDRD |= DATA_PORTD_MASK;
+  DDRB |= DATA_PORTB_MASK;
+#else
+  pinMode(DATA_B0_PIN, OUTPUT);
+  pinMode(DATA_B1_PIN, OUTPUT);
+  pinMode(DATA_B2_PIN, OUTPUT);
+  pinMode(DATA_B3_PIN, OUTPUT);
+  pinMode(DATA_B4_PIN, OUTPUT);
+  pinMode(DATA_B5_PIN, OUTPUT);
+  pinMode(DATA_B6_PIN, OUTPUT);
+  pinMode(DATA_B7_PIN, OUTPUT);
+#endif
+}
+
+void SetReadMode(void)
+{
+#ifdef FAST_DATA_BUS
+  DDRD &= ~DATA_PORTD_MASK;
+  DDRB &= ~DATA_PORTB_MASK;
+  // pull-ups on
+  PORTD |= DATA_PORTD_MASK;
+  PORTB |= DATA_PORTB_MASK;
+#else
+  pinMode(DATA_B0_PIN, INPUT_PULLUP);
+  pinMode(DATA_B1_PIN, INPUT_PULLUP);
+  pinMode(DATA_B2_PIN, INPUT_PULLUP);
+  pinMode(DATA_B3_PIN, INPUT_PULLUP);
+  pinMode(DATA_B4_PIN, INPUT_PULLUP);
+  pinMode(DATA_B5_PIN, INPUT_PULLUP);
+  pinMode(DATA_B6_PIN, INPUT_PULLUP);
+  pinMode(DATA_B7_PIN, INPUT_PULLUP);
+#endif
+}
+
+#ifdef FAST_ADDRESS_BUS
+inline void ShiftAddressBit(uint8_t value, uint8_t mask) __attribute__((always_inline));
+inline void ShiftAddressBit(uint8_t value, uint8_t mask)
+{
+  if (value & mask) {
+    PORTC |= _BV(SHIFT_DATA_BIT);
+  }
+  else {
+    PORTC &= ~_BV(SHIFT_DATA_BIT);
+  }
+  PORTC |= _BV(SHIFT_CLOCK_BIT);
+  PORTC &= ~_BV(SHIFT_CLOCK_BIT);
+}
+
+inline void ShiftAddressByte(uint8_t value) __attribute__((always_inline));
+inline void ShiftAddressByte(uint8_t value)
+{
+#ifdef ADDRESS_BUS_SPI
+  SPDR = value;
+  while (!(SPSR & _BV(SPIF)));
+#else
+  // MSB first, unrolled so every bit is a couple of sbi/cbi
+  ShiftAddressBit(value, 0x80);
+  ShiftAddressBit(value, 0x40);
+  ShiftAddressBit(value, 0x20);
+  ShiftAddressBit(value, 0x10);
+  ShiftAddressBit(value, 0x08);
+  ShiftAddressBit(value, 0x04);
+  ShiftAddressBit(value, 0x02);
+  ShiftAddressBit(value, 0x01);
+#endif
+}
+#endif
+
+void SetAddress(uint32_t address)
+{
+  byte registerTwo = highByte(address);
+  byte registerOne = lowByte(address);
+#ifdef FAST_ADDRESS_BUS
+  PORTC &= ~_BV(SHIFT_LATCH_BIT);
+#if ADDRESS_SHIFT_STAGES > 2
+  ShiftAddressByte((byte)(address >> 16));
+#endif
+  ShiftAddressByte(registerTwo);
+  ShiftAddressByte(registerOne);
+  PORTC |= _BV(SHIFT_LATCH_BIT);
+#else
+  digitalWrite(SHIFT_LATCH_PIN, LOW);
+#if ADDRESS_SHIFT_STAGES > 2
+  shiftOut(SHIFT_DATA_PIN, SHIFT_CLOCK_PIN, MSBFIRST, (byte)(address >> 16));
+#endif
+  shiftOut(SHIFT_DATA_PIN, SHIFT_CLOCK_PIN, MSBFIRST, registerTwo);
+  shiftOut(SHIFT_DATA_PIN, SHIFT_CLOCK_PIN, MSBFIRST, registerOne);
+  digitalWrite(SHIFT_LATCH_PIN, HIGH);
+#endif
+}
+
+uint8_t GetData(void)
+{
+#ifdef FAST_DATA_BUS
+  uint8_t portB = PINB;
+  return (PIND >> 2) | ((portB & 0x01) << 6) | ((portB & 0x04) << 5);
+#else
+  uint8_t data = 0;
+  data |= digitalRead(DATA_B0_PIN) << 0;
+  data |= digitalRead(DATA_B1_PIN) << 1;
+  data |= digitalRead(DATA_B2_PIN) << 2;
+  data |= digitalRead(DATA_B3_PIN) << 3;
+  data |= digitalRead(DATA_B4_PIN) << 4;
+  data |= digitalRead(DATA_B5_PIN) << 5;
+  data |= digitalRead(DATA_B6_PIN) << 6;
+  data |= digitalRead(DATA_B7_PIN) << 7;
+  return data;
+#endif
+}
+
+void SetData(uint8_t data)
+{
+#ifdef FAST_DATA_BUS
+  PORTD = (PORTD & ~DATA_PORTD_MASK) | (uint8_t)(data << 2);
+  PORTB = (PORTB & ~DATA_PORTB_MASK) | ((data >> 6) & 0x01) | ((data >> 5) & 0x04);
+#else
+  digitalWrite(DATA_B0_PIN, (data & (1 << 0)));
+  digitalWrite(DATA_B1_PIN, (data & (1 << 1)));
+  digitalWrite(DATA_B2_PIN, (data & (1 << 2)));
+  digitalWrite(DATA_B3_PIN, (data & (1 << 3)));
+  digitalWrite(DATA_B4_PIN, (data & (1 << 4)));
+  digitalWrite(DATA_B5_PIN, (data & (1 << 5)));
+  digitalWrite(DATA_B6_PIN, (data & (1 << 6)));
+  digitalWrite(DATA_B7_PIN, (data & (1 << 7)));
+#endif
+}
+
+#endif // BUS_H
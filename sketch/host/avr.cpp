@@ -0,0 +1,183 @@
+#include "avr.h"
+//----------------------------------------------------------------------
+
+static void PortCWritten(void);
+static void SpiDataWritten(void);
+//----------------------------------------------------------------------
+
+BusCost Cost;
+
+Register PINB, DDRB, PORTB;
+Register PINC, DDRC, PORTC(PortCWritten);
+Register PIND, DDRD, PORTD;
+Register SPCR, SPSR, SPDR(SpiDataWritten);
+
+const uint8_t DataPins[8] = { 2, 3, 4, 5, 6, 7, 8, 10 };
+
+static uint8_t previousPortC = 0;
+static uint32_t shiftRegister = 0;
+static uint32_t latchedAddress = 0;
+//----------------------------------------------------------------------
+
+static Register &InputRegister(uint8_t pin)
+{
+    return pin < 8 ? PIND : (pin < 14 ? PINB : PINC);
+}
+//----------------------------------------------------------------------
+
+static Register &ModeRegister(uint8_t pin)
+{
+    return pin < 8 ? DDRD : (pin < 14 ? DDRB : DDRC);
+}
+//----------------------------------------------------------------------
+
+static Register &OutputRegister(uint8_t pin)
+{
+    return pin < 8 ? PORTD : (pin < 14 ? PORTB : PORTC);
+}
+//----------------------------------------------------------------------
+
+static uint8_t BitMask(uint8_t pin)
+{
+    return 1 << (pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14));
+}
+//----------------------------------------------------------------------
+
+// digitalPinToTimer(), digitalPinToBitMask(), digitalPinToPort() and the
+// port register table, then turnOffPWM() when the pin has a timer
+static void CoreLookup(uint8_t pin, bool pwm)
+{
+    Cost.coreCalls++;
+    Cost.tableLookups += 4;
+    if(pwm && (pin == 3 || pin == 5 || pin == 6 || pin == 9 || pin == 10 || pin == 11)) {
+        Cost.registerAccesses += 2; // TCCRnA &= ~COMnx1
+    }
+}
+//----------------------------------------------------------------------
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    CoreLookup(pin, false);
+    Cost.registerAccesses += 2; // SREG saved and restored around cli()
+    if(mode == OUTPUT) {
+        ModeRegister(pin) |= BitMask(pin);
+        return;
+    }
+
+    ModeRegister(pin) &= ~BitMask(pin);
+    if(mode == INPUT_PULLUP) {
+        OutputRegister(pin) |= BitMask(pin);
+    }
+    else {
+        OutputRegister(pin) &= ~BitMask(pin);
+    }
+}
+//----------------------------------------------------------------------
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    CoreLookup(pin, true);
+    Cost.registerAccesses += 2;
+    if(value == LOW) {
+        OutputRegister(pin) &= ~BitMask(pin);
+    }
+    else {
+        OutputRegister(pin) |= BitMask(pin);
+    }
+}
+//----------------------------------------------------------------------
+
+int digitalRead(uint8_t pin)
+{
+    CoreLookup(pin, true);
+    return (InputRegister(pin) & BitMask(pin)) ? HIGH : LOW;
+}
+//----------------------------------------------------------------------
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value)
+{
+    Cost.coreCalls++;
+    for(int i = 0; i < 8; i++)
+    {
+        if(bitOrder == MSBFIRST) {
+            digitalWrite(dataPin, (value & (0x80 >> i)) ? HIGH : LOW);
+        }
+        else {
+            digitalWrite(dataPin, (value & (0x01 << i)) ? HIGH : LOW);
+        }
+        digitalWrite(clockPin, HIGH);
+        digitalWrite(clockPin, LOW);
+    }
+}
+//----------------------------------------------------------------------
+
+// 74HC595: shifts on the rising clock edge, outputs on the rising latch edge
+static void PortCWritten(void)
+{
+    uint8_t rising = PORTC.value & ~previousPortC;
+    previousPortC = PORTC.value;
+    if(rising & BitMask(A2)) {
+        shiftRegister = (shiftRegister << 1) | PinLevel(A0);
+    }
+    if(rising & BitMask(A1)) {
+        latchedAddress = shiftRegister;
+    }
+}
+//----------------------------------------------------------------------
+
+static void SpiDataWritten(void)
+{
+    shiftRegister = (shiftRegister << 8) | SPDR.value;
+    SPSR.value |= _BV(SPIF);
+}
+//----------------------------------------------------------------------
+
+void ResetCost(void)
+{
+    Cost.registerAccesses = 0;
+    Cost.tableLookups = 0;
+    Cost.coreCalls = 0;
+}
+//----------------------------------------------------------------------
+
+bool IsOutput(uint8_t pin)
+{
+    return ModeRegister(pin).value & BitMask(pin);
+}
+//----------------------------------------------------------------------
+
+uint8_t PinLevel(uint8_t pin)
+{
+    return (OutputRegister(pin).value & BitMask(pin)) ? HIGH : LOW;
+}
+//----------------------------------------------------------------------
+
+uint8_t ChipDataInput(void)
+{
+    uint8_t data = 0;
+    for(int i = 0; i < 8; i++) {
+        data |= PinLevel(DataPins[i]) << i;
+    }
+    return data;
+}
+//----------------------------------------------------------------------
+
+void SetChipDataOutput(uint8_t data)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        Register &input = InputRegister(DataPins[i]);
+        if(data & (1 << i)) {
+            input.value |= BitMask(DataPins[i]);
+        }
+        else {
+            input.value &= ~BitMask(DataPins[i]);
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+uint32_t LatchedAddress(void)
+{
+    return latchedAddress;
+}
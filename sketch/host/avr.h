@@ -0,0 +1,94 @@
+#ifndef AVR_H
+#define AVR_H
+//----------------------------------------------------------------------
+#include <stdint.h>
+//----------------------------------------------------------------------
+
+// Just enough of an ATmega328P and the Arduino core to run ../bus.h on a
+// PC. Every register read or write is counted; the core functions add what
+// wiring_digital.c does per call: four pin table lookups in flash, the
+// PWM timer switched off for pins 3, 5, 6, 9, 10 and 11, and SREG saved
+// around a read-modify-write of the port. shiftOut() is eight rounds of
+// three digitalWrite() calls, the SPI shifts a byte per SPDR write.
+
+struct BusCost
+{
+    uint32_t registerAccesses;
+    uint32_t tableLookups;
+    uint32_t coreCalls;
+};
+//----------------------------------------------------------------------
+
+extern BusCost Cost;
+//----------------------------------------------------------------------
+
+class Register
+{
+public:
+    explicit Register(void (*writeHook)(void) = nullptr) : written(writeHook) {}
+
+    uint8_t value = 0; // direct access for the board model, not counted
+
+    operator uint8_t() { Cost.registerAccesses++; return value; }
+    Register &operator=(uint8_t data) { Cost.registerAccesses++; value = data; Written(); return *this; }
+    Register &operator|=(int data) { Cost.registerAccesses += 2; value |= data; Written(); return *this; }
+    Register &operator&=(int data) { Cost.registerAccesses += 2; value &= data; Written(); return *this; }
+
+private:
+    void (*written)(void);
+
+    void Written(void) { if(written) written(); }
+};
+//----------------------------------------------------------------------
+
+extern Register PINB, DDRB, PORTB;
+extern Register PINC, DDRC, PORTC;
+extern Register PIND, DDRD, PORTD;
+extern Register SPCR, SPSR, SPDR;
+//----------------------------------------------------------------------
+
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+#define MSBFIRST 1
+
+#define SPIF  7
+#define SPE   6
+#define MSTR  4
+#define SPI2X 0
+
+#define _BV(bit) (1 << (bit))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value);
+//----------------------------------------------------------------------
+
+// the board: EPROM data line n is wired to DataPins[n], the 74HC595 chain
+// takes its data from A0 or MOSI, its clock from A2 or SCK and latches on A1
+extern const uint8_t DataPins[8];
+
+void ResetCost(void);
+bool IsOutput(uint8_t pin);
+uint8_t PinLevel(uint8_t pin);
+uint8_t ChipDataInput(void);
+void SetChipDataOutput(uint8_t data);
+uint32_t LatchedAddress(void);
+//----------------------------------------------------------------------
+#endif // AVR_H
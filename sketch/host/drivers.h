@@ -0,0 +1,29 @@
+#ifndef DRIVERS_H
+#define DRIVERS_H
+//----------------------------------------------------------------------
+#include <stdint.h>
+//----------------------------------------------------------------------
+
+// as in the stock sketch, 3 for the 32 pin adapter
+#ifndef ADDRESS_SHIFT_STAGES
+#define ADDRESS_SHIFT_STAGES 2
+#endif
+//----------------------------------------------------------------------
+
+// ../bus.h built once per configuration, each in its own namespace
+struct BusDriver
+{
+    const char *name;
+    void (*SetReadMode)(void);
+    void (*SetWriteMode)(void);
+    uint8_t (*GetData)(void);
+    void (*SetData)(uint8_t);
+    void (*SetAddress)(uint32_t);
+};
+//----------------------------------------------------------------------
+
+extern const BusDriver PinBusDriver;  // any board, digitalRead/digitalWrite and shiftOut
+extern const BusDriver PortBusDriver; // ATmega328P/168 port registers
+extern const BusDriver SpiBusDriver;  // port registers, address through the SPI
+//----------------------------------------------------------------------
+#endif // DRIVERS_H
@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Host build of the sketch's bus layer against a mocked
+# ATmega328P, prints the register cost per call
+#
+#-------------------------------------------------
+
+TARGET = bus_cost
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle qt
+
+SOURCES += \
+        main.cpp \
+    avr.cpp \
+    pinbus.cpp \
+    portbus.cpp \
+    spibus.cpp
+
+HEADERS += \
+    avr.h \
+    drivers.h \
+    ../bus.h
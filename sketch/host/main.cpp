@@ -0,0 +1,125 @@
+#include "avr.h"
+#include "drivers.h"
+#include <stdio.h>
+//----------------------------------------------------------------------
+
+// Runs every bus driver of ../bus.h against the mocked ATmega328P, checks
+// that the chip sees the same bytes and addresses through each of them and
+// prints what a call costs. Exits with 1 when a driver gets one wrong.
+
+static const BusDriver *Drivers[] = { &PinBusDriver, &PortBusDriver, &SpiBusDriver };
+static const int DRIVER_COUNT = sizeof(Drivers) / sizeof(Drivers[0]);
+//----------------------------------------------------------------------
+
+static int errors = 0;
+
+static void Fail(const BusDriver *driver, const char *what, uint32_t value)
+{
+    printf("%s: %s wrong for 0x%02X\n", driver->name, what, static_cast<unsigned>(value));
+    errors++;
+}
+//----------------------------------------------------------------------
+
+static void Check(const BusDriver *driver)
+{
+    driver->SetWriteMode();
+    for(int i = 0; i < 8; i++) {
+        if(!IsOutput(DataPins[i])) {
+            Fail(driver, "SetWriteMode", i);
+        }
+    }
+    for(int value = 0; value < 256; value++)
+    {
+        driver->SetData(value);
+        if(ChipDataInput() != value) {
+            Fail(driver, "SetData", value);
+        }
+    }
+
+    driver->SetReadMode();
+    for(int i = 0; i < 8; i++) {
+        if(IsOutput(DataPins[i]) || PinLevel(DataPins[i]) != HIGH) {
+            Fail(driver, "SetReadMode", i); // input with the pull-up on
+        }
+    }
+    for(int value = 0; value < 256; value++)
+    {
+        SetChipDataOutput(value);
+        if(driver->GetData() != value) {
+            Fail(driver, "GetData", value);
+        }
+    }
+
+    const uint32_t addressMask = (1UL << (8 * ADDRESS_SHIFT_STAGES)) - 1;
+    for(uint32_t address = 0; address <= addressMask; address += 7)
+    {
+        driver->SetAddress(address);
+        if((LatchedAddress() & addressMask) != address) {
+            Fail(driver, "SetAddress", address);
+        }
+    }
+}
+//----------------------------------------------------------------------
+
+enum OPERATION {
+    SET_READ_MODE,
+    SET_WRITE_MODE,
+    GET_DATA,
+    SET_DATA,
+    SET_ADDRESS,
+    OPERATION_COUNT
+};
+//----------------------------------------------------------------------
+
+static const char *OPERATION_NAMES[OPERATION_COUNT] = {
+    "SetReadMode", "SetWriteMode", "GetData", "SetData", "SetAddress"
+};
+//----------------------------------------------------------------------
+
+static BusCost Measure(const BusDriver *driver, OPERATION operation)
+{
+    ResetCost();
+    switch(operation)
+    {
+        case SET_READ_MODE: driver->SetReadMode(); break;
+        case SET_WRITE_MODE: driver->SetWriteMode(); break;
+        case GET_DATA: driver->GetData(); break;
+        case SET_DATA: driver->SetData(0x5A); break;
+        default: driver->SetAddress(0x5AA5); break;
+    }
+    return Cost;
+}
+//----------------------------------------------------------------------
+
+int main(void)
+{
+    for(int i = 0; i < DRIVER_COUNT; i++) {
+        Check(Drivers[i]);
+    }
+
+    printf("Cost per call with %d address stages: register accesses / pin table lookups / core calls\n\n", ADDRESS_SHIFT_STAGES);
+    printf("%-14s", "");
+    for(int i = 0; i < DRIVER_COUNT; i++) {
+        printf("%22s", Drivers[i]->name);
+    }
+    printf("\n");
+
+    for(int operation = 0; operation < OPERATION_COUNT; operation++)
+    {
+        printf("%-14s", OPERATION_NAMES[operation]);
+        for(int i = 0; i < DRIVER_COUNT; i++)
+        {
+            BusCost cost = Measure(Drivers[i], static_cast<OPERATION>(operation));
+            char cell[32];
+            snprintf(cell, sizeof(cell), "%u / %u / %u", cost.registerAccesses, cost.tableLookups, cost.coreCalls);
+            printf("%22s", cell);
+        }
+        printf("\n");
+    }
+
+    if(errors) {
+        printf("\n%d errors\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,17 @@
+#include "avr.h"
+#include "drivers.h"
+//----------------------------------------------------------------------
+
+namespace PinBus {
+#include "../bus.h"
+}
+//----------------------------------------------------------------------
+
+const BusDriver PinBusDriver = {
+    "digitalWrite/shiftOut",
+    PinBus::SetReadMode,
+    PinBus::SetWriteMode,
+    PinBus::GetData,
+    PinBus::SetData,
+    PinBus::SetAddress
+};
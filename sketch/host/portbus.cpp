@@ -0,0 +1,22 @@
+#define __AVR_ATmega328P__
+#include "avr.h"
+#include "drivers.h"
+//----------------------------------------------------------------------
+
+namespace PortBus {
+#include "../bus.h"
+}
+//----------------------------------------------------------------------
+
+#if !defined(FAST_DATA_BUS) || !defined(FAST_ADDRESS_BUS)
+#error "the port register buses are not selected for ATmega328P"
+#endif
+
+const BusDriver PortBusDriver = {
+    "port registers",
+    PortBus::SetReadMode,
+    PortBus::SetWriteMode,
+    PortBus::GetData,
+    PortBus::SetData,
+    PortBus::SetAddress
+};
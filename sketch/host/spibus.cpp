@@ -0,0 +1,23 @@
+#define __AVR_ATmega328P__
+#define ADDRESS_BUS_SPI
+#include "avr.h"
+#include "drivers.h"
+//----------------------------------------------------------------------
+
+namespace SpiBus {
+#include "../bus.h"
+}
+//----------------------------------------------------------------------
+
+#if !defined(FAST_DATA_BUS) || !defined(FAST_ADDRESS_BUS)
+#error "the port register buses are not selected for ATmega328P"
+#endif
+
+const BusDriver SpiBusDriver = {
+    "SPI",
+    SpiBus::SetReadMode,
+    SpiBus::SetWriteMode,
+    SpiBus::GetData,
+    SpiBus::SetData,
+    SpiBus::SetAddress
+};
@@ -1,21 +1,18 @@
+#if defined(__AVR__)
+#include <util/crc16.h>
+#endif
+
 #define TRUE 1
 #define FALSE 0
 
 /* 74HC595 control (address lines) */
-#define SHIFT_LATCH_PIN A1
-#define SHIFT_CLOCK_PIN A2
-#define SHIFT_DATA_PIN  A0
-#define ADDRESS_A10_PIN 13
-
-/* Data pins */
-#define DATA_B0_PIN 2
-#define DATA_B1_PIN 3
-#define DATA_B2_PIN 4
-#define DATA_B3_PIN 5
-#define DATA_B4_PIN 6
-#define DATA_B5_PIN 7
-#define DATA_B6_PIN 8
-#define DATA_B7_PIN 10
+// Chained stages: two drive A0..A15, a third one on the 32 pin adapter drives
+// A16..A19 (Q0..Q3, Q2 is ~PGM on 27C010 and 27C020) for 27C010 to 27C080
+#define ADDRESS_SHIFT_STAGES 2
+// Uncomment to clock the 74HC595 chain with the hardware SPI (needs D10 to D13 free, see below)
+//#define ADDRESS_BUS_SPI
+
+#include "bus.h"
 
 /* Chip control */
 #define CHIP_ENABLE_PIN   A3
@@ -23,9 +20,32 @@
 #define POWER_ENABLE_PIN  A5 // For 27C16 and 27C32
 #define READ_VOLTAGE_ENABLE_PIN 13 // For 27C16
 #define PROGRAMMING_VOLTAGE_ENABLE_C16_PIN   9 // For 27C16
-#define PROGRAMMING_VOLTAGE_ENABLE_C32_PIN   12 // For 27C32 and 27C512
+#define PROGRAMMING_VOLTAGE_ENABLE_C32_PIN   12 // For 27C32, 27C512 and 27C080
 #define PROGRAMMING_VOLTAGE_ENABLE_OTHER_PIN 11 // For other
 
+#ifdef ADDRESS_BUS_SPI
+// The SPI master owns D10 to D13: MOSI (D11) and SCK (D13) are driven by it,
+// SS (D10) has to stay an output or a low level drops it out of master mode,
+// and MISO (D12) is forced to an input, so a Vpp switch left there would
+// silently never turn on. The stock board has the data bus on D10, the
+// 27C32/27C512 Vpp on D12, the other Vpp on D11 and the 27C16 read voltage
+// on D13, with no spare pins to move them to. ADDRESS_A10_PIN is only ever
+// made an output, which SCK is anyway.
+#define IS_SPI_PIN(pin) ((pin) >= 10 && (pin) <= 13)
+#if IS_SPI_PIN(DATA_B0_PIN) || IS_SPI_PIN(DATA_B1_PIN) || IS_SPI_PIN(DATA_B2_PIN) || IS_SPI_PIN(DATA_B3_PIN) || \
+    IS_SPI_PIN(DATA_B4_PIN) || IS_SPI_PIN(DATA_B5_PIN) || IS_SPI_PIN(DATA_B6_PIN) || IS_SPI_PIN(DATA_B7_PIN)
+#error "ADDRESS_BUS_SPI needs the data bus moved off D10 to D13"
+#endif
+#if IS_SPI_PIN(PROGRAMMING_VOLTAGE_ENABLE_C16_PIN) || IS_SPI_PIN(PROGRAMMING_VOLTAGE_ENABLE_C32_PIN) || \
+    IS_SPI_PIN(PROGRAMMING_VOLTAGE_ENABLE_OTHER_PIN)
+#error "ADDRESS_BUS_SPI needs the Vpp switches moved off D10 to D13 (D12 is MISO, an input)"
+#endif
+#if IS_SPI_PIN(READ_VOLTAGE_ENABLE_PIN) || IS_SPI_PIN(CHIP_ENABLE_PIN) || IS_SPI_PIN(OUTPUT_ENABLE_PIN) || \
+    IS_SPI_PIN(POWER_ENABLE_PIN)
+#error "ADDRESS_BUS_SPI needs the chip control moved off D10 to D13"
+#endif
+#endif
+
 /* Voltage control (for programming chips) */
 #define VOLTAGE_CONTROL_PIN A6
 #define RESISTOR_TOP_VALUE 9870.0
@@ -34,6 +54,55 @@
 // read buffer length
 #define BUF_LEN 16
 
+// serial link
+#define DEFAULT_BAUD_RATE 115200
+#define BAUD_TEST_TIMEOUT 1000
+#define BAUD_TEST_LEN     8
+
+// binary frames: FRAME_SYNC, opcode, sequence, length, payload[length], CRC16 (LSB first)
+// CRC16 is CCITT (0x1021, init 0xFFFF) over opcode, sequence, length and payload
+// addresses (addr) are u16, u32 once CAPABILITY_WIDE_ADDRESS is enabled
+#define PROTOCOL_VERSION  13
+#define FRAME_SYNC        0xA5
+#define FRAME_HEADER_LEN  4
+#define FRAME_CRC_LEN     2
+#define FRAME_MAX_PAYLOAD 128
+// transfer block size, negotiated with FRAME_OPTIONS as a power of two; the
+// maximum is bounded by SRAM: the receive, stream, decode and RLE buffers
+// and the block on the stack all grow with it
+#define FRAME_BLOCK_LEN     64
+#define FRAME_MIN_BLOCK_LEN 16
+#define FRAME_MAX_BLOCK_LEN FRAME_MAX_PAYLOAD
+// blocks the host may send ahead during a WRITE: one is programmed
+// while the next one is received
+#define WRITE_WINDOW      2
+#define WRITE_TIMEOUT     1000
+// bytes read back between two polls of the stream, well under the 64 bytes
+// serial buffer at 2 Mbaud
+#define WRITE_READBACK_LEN 8
+
+// capabilities reported by FRAME_INFO and enabled with FRAME_OPTIONS
+#define CAPABILITY_RLE    0x01
+#define CAPABILITY_WIDE_ADDRESS 0x02 // only with the third address stage
+#if ADDRESS_SHIFT_STAGES > 2
+#define CAPABILITIES (CAPABILITY_RLE | CAPABILITY_WIDE_ADDRESS)
+#else
+#define CAPABILITIES CAPABILITY_RLE
+#endif
+
+// run-length codec: 0x00..0x7F = (n + 1) literal bytes follow,
+// 0x80..0xFF = next byte repeated (n & 0x7F) + 1 times
+#define RLE_MIN_RUN       3
+#define RLE_MAX_RUN       128
+#define RLE_MAX_LITERAL   63
+
+// bytes counted by the number of pulses they took, the last bin holds the rest
+#define PULSE_HISTOGRAM_LEN 8
+
+// verify checksums: CRC32 over 256 B to 4 KB blocks
+#define CRC_MIN_SHIFT     8
+#define CRC_MAX_SHIFT     12
+
 // commands
 #define MESSAGE_COMMAND_FLAG        "!@#$"
 #define MESSAGE_SELECT_NONE         "NONE"
@@ -52,6 +121,9 @@
 #define MESSAGE_BLOCK               "BLCK"
 #define MESSAGE_READ_BYTE           "RDBT"
 #define MESSAGE_WRITE_BYTE          "WRBT"
+#define MESSAGE_ABORT               "ABRT"
+#define MESSAGE_BAUD_RATE           "BAUD"
+#define MESSAGE_BAUD_TEST           "BTST"
 
 enum CHIP_TYPE {
   NONE = 0,
@@ -60,7 +132,55 @@ enum CHIP_TYPE {
   C64 = 3,
   C128 = 4,
   C256 = 5,
-  C512 = 6
+  C512 = 6,
+  C010 = 7, // 1 to 8 Mbit parts need ADDRESS_SHIFT_STAGES 3
+  C020 = 8,
+  C040 = 9,
+  C080 = 10
+};
+
+enum FRAME_OPCODE {
+  // host requests
+  FRAME_HELLO = 0x01,
+  FRAME_SELECT = 0x02,
+  FRAME_VOLTAGE = 0x03,
+  FRAME_READ = 0x04,     // optional: first and last address (addr, addr)
+  FRAME_WRITE = 0x05,    // optional: first and last address (addr, addr)
+  FRAME_DATA = 0x06, // both directions
+  FRAME_OPTIONS = 0x07,  // capabilities (u8), optional: block length (u8)
+  FRAME_DATA_RLE = 0x08, // both directions, FRAME_DATA run-length encoded
+  FRAME_BLANK = 0x09,    // optional: stop at the first programmed byte (u8)
+  FRAME_CRC = 0x0A,      // block size as a power of two (u8, CRC_MIN_SHIFT..CRC_MAX_SHIFT)
+  FRAME_READ_BYTES = 0x0B,  // addresses (addr each)
+  FRAME_WRITE_BYTES = 0x0C, // address (addr) and value (u8) each
+  FRAME_ABORT = 0x0D,       // stops the running operation, ignored without one
+  FRAME_STATUS = 0x0E,      // answered with FRAME_STATUS_INFO, also while an operation runs
+  FRAME_TIMING = 0x0F,      // after SELECT: pulse width (u16, us), max pulses (u8), overprogram factor (u8), Vpp line (u8)
+  // device responses
+  FRAME_OK = 0x40,         // after a written block: skipped (u8), programmed (u8), next address (addr)
+  FRAME_ERROR = 0x41,
+  FRAME_BLOCK = 0x42,
+  FRAME_VOLTAGE_INFO = 0x43,
+  FRAME_INFO = 0x44,       // version (u8), block length (u8), capabilities (u8), maximum block length (u8)
+  FRAME_BLANK_INFO = 0x45, // blank (u8), first programmed address (addr), programmed bytes (u32), programmed bits (u32)
+  FRAME_CRC_TABLE = 0x46,  // CRC32 per block (u32 each), followed by FRAME_OK
+  FRAME_PULSE_INFO = 0x47, // after the last block of a WRITE: bytes per pulse count (u32 * PULSE_HISTOGRAM_LEN)
+  FRAME_CREDIT = 0x48,     // start of a WRITE: blocks the host may send ahead (u8)
+  FRAME_BYTES = 0x49,      // answer to READ_BYTES and WRITE_BYTES: values read (u8 each)
+  FRAME_STATUS_INFO = 0x4A // running command (u8, WAIT when idle), next address (addr), last address (addr)
+};
+
+enum FRAME_ERROR_CODE {
+  ERROR_UNKNOWN_COMMAND = 1,
+  ERROR_CRC = 2,
+  ERROR_NO_CHIP = 3,
+  ERROR_LOW_VOLTAGE = 4, // voltage (u16, 10 mV)
+  ERROR_BLOCK = 5,       // bytes received (u8), address (addr)
+  ERROR_VERIFY = 6,      // address (addr), wrote (u8), read (u8)
+  ERROR_RANGE = 7,       // also a 1 to 8 Mbit SELECT without wide addresses
+  ERROR_NOT_ERASED = 8,  // address (addr), wanted (u8), found (u8)
+  ERROR_ABORTED = 9,     // next address (addr)
+  ERROR_BUSY = 10        // anything but ABORT and STATUS while an operation runs
 };
 
 enum COMMAND_MODE {
@@ -69,30 +189,163 @@ enum COMMAND_MODE {
   WRITE,
   VOLTAGE,
   READ_BYTE,
-  WRITE_BYTE
+  WRITE_BYTE,
+  BAUD,
+  BLANK,
+  CRC
+};
+
+// Per chip constants, folded at compile time in the specialized loops
+constexpr uint32_t ReadAddressMask(CHIP_TYPE chip)
+{
+  // A14 (C256 and C512) is ~PGM for C64 and C128, A18 (C040 and C080) for C010 and C020
+  return (chip == C64 || chip == C128) ? 0x4000 : (chip == C010 || chip == C020) ? 0x40000 : 0x0000;
+}
+
+// Vpp switches, TIMING names them by line
+enum VPP_LINE {
+  VPP_C16 = 0,
+  VPP_C32 = 1,
+  VPP_OTHER = 2
+};
+
+typedef void (*ReadBlockFunction)(uint32_t address, uint8_t *buffer, uint8_t length);
+typedef uint8_t (*ProgramByteFunction)(uint32_t address, uint8_t data);
+
+// SELECT loads a chip's entry; the timing is the firmware default, the host
+// retunes it per part with TIMING. Programming pulses follow the
+// intelligent/quick-pulse algorithms: pulses of pulseWidth us with a verify
+// after each, at most maxPulses, then one overprogram pulse of
+// overprogramFactor times the pulses it took (none for quick-pulse parts)
+struct ChipEntry {
+  uint32_t endAddress;
+  bool lowPower; // POWER_ENABLE low, 27C16 and 27C32 take Vcc on a moved leg
+  ReadBlockFunction readBlock;
+  ProgramByteFunction programByte;
+  uint16_t pulseWidth;
+  uint8_t maxPulses;
+  uint8_t overprogramFactor;
+  uint8_t vppLine;
 };
 
-void SetWriteMode(void);
-void SetReadMode(void);
-void SetAddress(uint16_t address);
-uint8_t GetData(void);
-void SetData(uint8_t data);
-uint8_t ReadByte(uint16_t address);
-void WriteByte(uint16_t address, uint8_t data);
 double GetVoltage(void);
-void SetProgrammingVoltage(bool enable);
-uint16_t GenerateAddress(uint16_t address);
 void SelectChip(CHIP_TYPE newChip);
+void StartReading(void);
+void StopReading(void);
+bool CheckProgrammingVoltage(void);
+void ReportByteError(uint8_t code, uint32_t address, uint8_t wrote, uint8_t read);
+void PrintHexByte(uint8_t value);
+void PollCommand(void);
+void SendStatus(void);
+void AbortOperation(void);
+void EndOperation(void);
 void WaitForData(void);
-uint8_t VerifyData(void);
 void WaitMillis(unsigned long period);
+void WaitMicros(uint32_t period);
+bool IsBaudRateSupported(unsigned long baudRate);
+bool WaitForBaudTest(void);
+uint16_t Crc16Update(uint16_t crc, uint8_t data);
+uint32_t Crc32Update(uint32_t crc, uint8_t data);
+bool ReadFrame(void);
+void PollFrame(void);
+bool TakeStreamFrame(void);
+void DrainSerial(void);
+void SendFrame(uint8_t opcode, const uint8_t *payload, uint8_t length);
+void SendError(uint8_t code, const uint8_t *arguments, uint8_t length);
+void HandleFrame(void);
+bool SetRange(void);
+uint8_t AddressLength(void);
+uint8_t PutAddress(uint8_t *buffer, uint32_t address);
+uint32_t GetAddress(const uint8_t *buffer);
+void RleEncodeByte(uint8_t data);
+void RleEndRun(void);
+void RleEmitLiterals(void);
+void RleReserve(uint8_t length);
+void RleFlush(void);
+int16_t RleDecode(const uint8_t *input, uint8_t length, uint8_t *output, uint8_t capacity);
+template <CHIP_TYPE chip> void ReadBlock(uint32_t address, uint8_t *buffer, uint8_t length);
+template <CHIP_TYPE chip> uint8_t ProgramByte(uint32_t address, uint8_t data);
+template <CHIP_TYPE chip> uint8_t VerifyData(void);
+template <CHIP_TYPE chip> void ProgramPulse(uint8_t data, uint32_t width);
+
+const ChipEntry ChipTable[] PROGMEM = {
+  { 0x0000, false, NULL, NULL, 0, 0, 0, VPP_OTHER },
+  { 0x07ff, true, ReadBlock<C16>, ProgramByte<C16>, 15000, 1, 0, VPP_C16 },
+  { 0x0fff, true, ReadBlock<C32>, ProgramByte<C32>, 100, 25, 3, VPP_C32 },
+  { 0x1fff, false, ReadBlock<C64>, ProgramByte<C64>, 100, 25, 3, VPP_OTHER },
+  { 0x3fff, false, ReadBlock<C128>, ProgramByte<C128>, 100, 25, 3, VPP_OTHER },
+  { 0x7fff, false, ReadBlock<C256>, ProgramByte<C256>, 100, 25, 0, VPP_OTHER },
+  { 0xffff, false, ReadBlock<C512>, ProgramByte<C512>, 100, 25, 0, VPP_C32 },
+  // Vpp goes to pin 1 of the 32 pin socket, the C080 takes it on ~OE/Vpp
+  // (pin 24), which lines up with the 27C512's ~OE/Vpp at 28 pin socket pin 22
+  { 0x1ffff, false, ReadBlock<C010>, ProgramByte<C010>, 100, 25, 0, VPP_OTHER },
+  { 0x3ffff, false, ReadBlock<C020>, ProgramByte<C020>, 100, 25, 0, VPP_OTHER },
+  { 0x7ffff, false, ReadBlock<C040>, ProgramByte<C040>, 100, 25, 0, VPP_OTHER },
+  { 0xfffff, false, ReadBlock<C080>, ProgramByte<C080>, 100, 25, 0, VPP_C32 }
+};
+const uint8_t VppLinePins[] = {
+  PROGRAMMING_VOLTAGE_ENABLE_C16_PIN,
+  PROGRAMMING_VOLTAGE_ENABLE_C32_PIN,
+  PROGRAMMING_VOLTAGE_ENABLE_OTHER_PIN
+};
 
 CHIP_TYPE ChipSelected = NONE;
 COMMAND_MODE CommandMode = WAIT;
-uint16_t StartAddress = 0x0000;
-uint16_t EndAddress = 0x0000;
-uint8_t ReadingBuffer[BUF_LEN];
+uint32_t StartAddress = 0x0000;
+uint32_t EndAddress = 0x0000;
+uint32_t RangeStart = 0x0000;
+uint32_t RangeEnd = 0x0000;
+uint16_t ByteAddress = 0x0000; // RDBT and WRBT arguments
+uint8_t ByteValue = 0x00;
+uint8_t ReadingBuffer[BUF_LEN + 1];
 double programmingVoltage = 0.0;
+unsigned long BaudRate = DEFAULT_BAUD_RATE;
+unsigned long NewBaudRate = DEFAULT_BAUD_RATE;
+const uint8_t BaudTestPattern[BAUD_TEST_LEN] = { 0x55, 0xAA, 0x00, 0xFF, 0x0F, 0xF0, 0x33, 0xCC };
+ReadBlockFunction ReadChipBlock = NULL;
+ProgramByteFunction ProgramChipByte = NULL;
+uint16_t PulseWidth = 0;
+uint8_t MaxPulses = 0;
+uint8_t OverprogramFactor = 0;
+uint8_t VppPin = PROGRAMMING_VOLTAGE_ENABLE_OTHER_PIN;
+bool FrameMode = false; // the last command came as a frame, answer with frames
+uint8_t FrameSequence = 0;
+uint8_t ReceivedOpcode = 0;
+uint8_t ReceivedLength = 0;
+uint8_t ReceivedPayload[FRAME_MAX_PAYLOAD];
+uint8_t BlockBuffer[FRAME_MAX_BLOCK_LEN];
+uint8_t BlockLength = FRAME_BLOCK_LEN;
+uint8_t Options = 0;
+uint8_t RleOutput[FRAME_MAX_PAYLOAD];
+uint8_t RleOutputLength = 0;
+uint8_t RleLiterals[RLE_MAX_LITERAL];
+uint8_t RleLiteralCount = 0;
+uint8_t RleRunByte = 0;
+uint8_t RleRunCount = 0;
+bool BlankEarlyExit = false;
+uint8_t CrcBlockShift = CRC_MIN_SHIFT;
+uint32_t PulseHistogram[PULSE_HISTOGRAM_LEN];
+bool WriteStreaming = false; // poll frames in while programming
+uint8_t StreamFrame[FRAME_HEADER_LEN + FRAME_MAX_PAYLOAD + FRAME_CRC_LEN];
+uint8_t StreamLength = 0;
+bool StreamReady = false;
+// READ, WRITE, BLANK and CRC do one block per loop() pass from OperationAddress,
+// commands are polled in between so they can be aborted
+bool OperationRunning = false;
+uint32_t OperationAddress = 0;
+uint8_t WriteAck[6];
+uint8_t WriteAckLength = 0;
+bool WriteAckPending = false;
+uint32_t BlankFirst = 0;
+uint32_t BlankBytes = 0;
+uint32_t BlankBits = 0;
+uint32_t OperationCrc = 0;
+uint8_t CrcTableLength = 0; // the table is collected in BlockBuffer
+// CRC-32 (reflected 0xEDB88320) a nibble at a time, same values as zlib
+const uint32_t Crc32Table[16] PROGMEM = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
 
 void setup()
 {
@@ -101,6 +354,11 @@ void setup()
   pinMode(SHIFT_CLOCK_PIN, OUTPUT);
   pinMode(SHIFT_DATA_PIN,  OUTPUT);
   pinMode(ADDRESS_A10_PIN, OUTPUT);
+#ifdef ADDRESS_BUS_SPI
+  pinMode(10, OUTPUT); // SS must stay an output in master mode
+  SPCR = _BV(SPE) | _BV(MSTR); // MSB first, mode 0
+  SPSR = _BV(SPI2X); // F_CPU / 2
+#endif
 
   // Chip control
   pinMode(CHIP_ENABLE_PIN, OUTPUT);
@@ -121,422 +379,1391 @@ void setup()
   // Data pins
   SetReadMode();
 
-  Serial.begin(115200);
+  Serial.begin(DEFAULT_BAUD_RATE);
   Serial.println("Arduino 27CXXX EEPROM programmer");
 }
 
 void loop()
 {
+  // a running operation takes one block per pass, a streamed write
+  // picks up ABORT from the stream instead
+  if (OperationRunning && CommandMode != WRITE) {
+    PollCommand();
+  }
+
   switch (CommandMode)
   {
     case READ:
-      if (ChipSelected == NONE)
+      if (!OperationRunning)
       {
-        CommandMode = WAIT;
-        break;
-      }
-
-      Serial.print(MESSAGE_RESPONSE_FLAG);
-      Serial.println(MESSAGE_READ_CHIP);
+        if (ChipSelected == NONE)
+        {
+          if (FrameMode) {
+            SendError(ERROR_NO_CHIP, NULL, 0);
+          }
+          CommandMode = WAIT;
+          break;
+        }
 
-      SetReadMode();
+        if (!FrameMode)
+        {
+          Serial.print(MESSAGE_RESPONSE_FLAG);
+          Serial.println(MESSAGE_READ_CHIP);
+        }
 
-      if (ChipSelected == C16) {
-        digitalWrite(READ_VOLTAGE_ENABLE_PIN, LOW);
+        StartReading();
+        OperationAddress = RangeStart;
+        OperationRunning = true;
+        break;
       }
-      digitalWrite(CHIP_ENABLE_PIN, LOW);
-      digitalWrite(OUTPUT_ENABLE_PIN, LOW);
 
-      uint8_t buffer[BUF_LEN];
-      for (uint16_t i = StartAddress; i < EndAddress; i += BUF_LEN)
+      if (OperationAddress <= RangeEnd)
       {
-        for (uint8_t j = 0; j < BUF_LEN; j++) {
-          buffer[j] = ReadByte(i + j);
+        uint8_t buffer[FRAME_MAX_BLOCK_LEN];
+        uint8_t length = FrameMode ? BlockLength : BUF_LEN;
+        if (RangeEnd - OperationAddress + 1 < length) {
+          length = RangeEnd - OperationAddress + 1;
         }
-        Serial.write(buffer, BUF_LEN);
-      }
 
-      digitalWrite(OUTPUT_ENABLE_PIN, HIGH);
-      digitalWrite(CHIP_ENABLE_PIN, HIGH);
+        ReadChipBlock(OperationAddress, buffer, length);
+        if (FrameMode && (Options & CAPABILITY_RLE))
+        {
+          for (uint8_t j = 0; j < length; j++) {
+            RleEncodeByte(buffer[j]);
+          }
+        }
+        else if (FrameMode) {
+          SendFrame(FRAME_DATA, buffer, length);
+        }
+        else {
+          Serial.write(buffer, length);
+        }
+        OperationAddress += length;
+        break;
+      }
 
-      if (ChipSelected == C16) {
-        digitalWrite(READ_VOLTAGE_ENABLE_PIN, HIGH);
+      if (FrameMode && (Options & CAPABILITY_RLE)) {
+        RleFlush();
       }
 
-      Serial.print(MESSAGE_RESPONSE_FLAG);
-      Serial.println(MESSAGE_OK);
+      StopReading();
 
-      CommandMode = WAIT;
+      if (FrameMode) {
+        SendFrame(FRAME_OK, NULL, 0);
+      }
+      else
+      {
+        Serial.print(MESSAGE_RESPONSE_FLAG);
+        Serial.println(MESSAGE_OK);
+      }
+
+      EndOperation();
       break;
     case WRITE:
-      if (ChipSelected == NONE)
+      if (!OperationRunning)
       {
-        CommandMode = WAIT;
+        if (ChipSelected == NONE)
+        {
+          if (FrameMode) {
+            SendError(ERROR_NO_CHIP, NULL, 0);
+          }
+          CommandMode = WAIT;
+          break;
+        }
+
+        if (!CheckProgrammingVoltage())
+        {
+          CommandMode = WAIT;
+          break;
+        }
+
+        if (!FrameMode)
+        {
+          Serial.print(MESSAGE_RESPONSE_FLAG);
+          Serial.println(MESSAGE_WRITE_CHIP);
+        }
+
+        memset(PulseHistogram, 0, sizeof(PulseHistogram));
+
+        if (FrameMode)
+        {
+          uint8_t credit = WRITE_WINDOW;
+          WriteStreaming = true;
+          StreamLength = 0;
+          StreamReady = false;
+          SendFrame(FRAME_CREDIT, &credit, sizeof(credit));
+        }
+
+        OperationAddress = RangeStart;
+        WriteAckPending = false;
+        OperationRunning = true;
         break;
       }
 
-      programmingVoltage = GetVoltage();
-      if (programmingVoltage <= 6.0)
+      if (OperationAddress <= RangeEnd)
       {
-        Serial.print(MESSAGE_RESPONSE_FLAG);
-        Serial.print(MESSAGE_ERROR);
-        Serial.print("Low programming voltage (");
-        Serial.print(programmingVoltage, 2);
-        Serial.println("V)");
-        CommandMode = WAIT;
-        break;
-      }
+        uint32_t i = OperationAddress;
+        uint8_t blockLength = FrameMode ? BlockLength : BUF_LEN;
+        if (RangeEnd - i + 1 < blockLength) {
+          blockLength = RangeEnd - i + 1;
+        }
 
-      Serial.print(MESSAGE_RESPONSE_FLAG);
-      Serial.println(MESSAGE_WRITE_CHIP);
+        uint8_t *data = ReadingBuffer;
+        uint8_t count = 0;
+        if (FrameMode)
+        {
+          // the host streams ahead, this block usually arrived during the last one
+          bool received;
+          do
+          {
+            unsigned long waitStart = millis();
+            while (!StreamReady && millis() - waitStart < WRITE_TIMEOUT) {
+              PollFrame();
+            }
+            received = TakeStreamFrame();
+            if (received && ReceivedOpcode == FRAME_STATUS) {
+              SendStatus();
+            }
+          } while (received && ReceivedOpcode == FRAME_STATUS);
 
-      for (uint16_t i = StartAddress; i < EndAddress; i += BUF_LEN)
-      {
-        Serial.print(MESSAGE_RESPONSE_FLAG);
-        Serial.print(MESSAGE_BLOCK);
-        Serial.println(i);
+          if (received && ReceivedOpcode == FRAME_ABORT)
+          {
+            AbortOperation();
+            break;
+          }
 
-        WaitForData();
+          // the stream buffer is free again, acknowledging returns the credit
+          if (WriteAckPending)
+          {
+            SendFrame(FRAME_OK, WriteAck, WriteAckLength);
+            WriteAckPending = false;
+          }
 
-        uint8_t count = Serial.readBytes((char*)ReadingBuffer, BUF_LEN);
-        if (count != BUF_LEN)
+          if (received && ReceivedOpcode == FRAME_DATA)
+          {
+            count = ReceivedLength;
+            data = ReceivedPayload;
+          }
+          else if (received && ReceivedOpcode == FRAME_DATA_RLE && (Options & CAPABILITY_RLE))
+          {
+            int16_t decoded = RleDecode(ReceivedPayload, ReceivedLength, BlockBuffer, sizeof(BlockBuffer));
+            count = decoded < 0 ? 0 : decoded;
+            data = BlockBuffer;
+          }
+        }
+        else
         {
           Serial.print(MESSAGE_RESPONSE_FLAG);
-          Serial.print(MESSAGE_ERROR);
-          Serial.print(count);
-          Serial.print(" bytes received for block 0x");
-          Serial.println(i, HEX);
-          CommandMode = WAIT;
-          break;
+          Serial.print(MESSAGE_BLOCK);
+          Serial.println(i);
+
+          WaitForData();
+
+          count = Serial.readBytes((char*)ReadingBuffer, BUF_LEN);
         }
 
-        for (uint16_t j = 0; j < BUF_LEN; j++)
+        if (count != blockLength)
         {
-          // Write byte
-          SetWriteMode();
-          SetProgrammingVoltage(true);
-          WriteByte((i + j), ReadingBuffer[j]);
-          SetProgrammingVoltage(false);
-
-          // Verify byte
-          uint8_t verify = VerifyData();
-          if(ReadingBuffer[j] != verify)
+          if (FrameMode)
           {
-            WaitMillis(1);
-            verify = VerifyData();
+            uint8_t arguments[5] = { count };
+            SendError(ERROR_BLOCK, arguments, 1 + PutAddress(arguments + 1, i));
           }
-          
-          if(ReadingBuffer[j] != verify)
+          else
           {
             Serial.print(MESSAGE_RESPONSE_FLAG);
             Serial.print(MESSAGE_ERROR);
-            Serial.print("Wrote 0x");
-            Serial.print(ReadingBuffer[j], HEX);
-            Serial.print(", read 0x");
-            Serial.print(verify, HEX);
-            Serial.print(", address 0x");
-            Serial.println(i + j, HEX);
-            CommandMode = WAIT;
+            Serial.print(count);
+            Serial.print(" bytes received for block 0x");
+            Serial.println(i, HEX);
+          }
+          EndOperation();
+          break;
+        }
+
+        // Read the block first: matching bytes need no pulse and
+        // a bit that has to go back from 0 to 1 needs an erased chip.
+        // The host is already sending the next block, so a streamed write
+        // reads back in pieces and empties the serial buffer in between,
+        // also for blocks that turn out to need no pulse at all
+        uint8_t current[FRAME_MAX_BLOCK_LEN];
+        StartReading();
+        for (uint8_t j = 0; j < blockLength; j += WRITE_READBACK_LEN)
+        {
+          uint8_t length = blockLength - j < WRITE_READBACK_LEN ? blockLength - j : WRITE_READBACK_LEN;
+          ReadChipBlock(i + j, current + j, length);
+          if (WriteStreaming) {
+            PollFrame();
+          }
+        }
+        StopReading();
+
+        uint8_t skipped = 0;
+        for (uint8_t j = 0; j < blockLength; j++)
+        {
+          if (current[j] == data[j])
+          {
+            skipped++;
+            continue;
+          }
+          if ((current[j] & data[j]) == data[j]) {
+            continue;
+          }
+
+          ReportByteError(ERROR_NOT_ERASED, i + j, data[j], current[j]);
+          EndOperation();
+          break;
+        }
+
+        if (!OperationRunning) {
+          break;
+        }
+
+        for (uint16_t j = 0; j < blockLength; j++)
+        {
+          if (current[j] == data[j]) {
+            continue;
+          }
+          if (WriteStreaming)
+          {
+            // an ABORT behind the blocks in flight stops the write at the next byte
+            PollFrame();
+            if (StreamReady && StreamFrame[1] == FRAME_ABORT && TakeStreamFrame())
+            {
+              AbortOperation();
+              break;
+            }
+          }
+
+          // Write and verify byte
+          uint8_t verify = ProgramChipByte(i + j, data[j]);
+          if(data[j] != verify)
+          {
+            ReportByteError(ERROR_VERIFY, i + j, data[j], verify);
+            EndOperation();
             break;
           }
         }
 
-        if (CommandMode != WRITE) {
+        if (!OperationRunning) {
           break;
         }
 
-        Serial.print(MESSAGE_RESPONSE_FLAG);
-        Serial.println(MESSAGE_OK);
+        if (FrameMode)
+        {
+          // sent once the next block is in, acknowledgments are cumulative
+          WriteAck[0] = skipped;
+          WriteAck[1] = blockLength - skipped;
+          WriteAckLength = 2 + PutAddress(WriteAck + 2, i + blockLength);
+          WriteAckPending = true;
+        }
+        else
+        {
+          Serial.print(MESSAGE_RESPONSE_FLAG);
+          Serial.println(MESSAGE_OK);
+        }
+        OperationAddress += blockLength;
+        break;
       }
 
-      CommandMode = WAIT;
+      if (WriteAckPending) {
+        SendFrame(FRAME_OK, WriteAck, WriteAckLength);
+      }
+      WriteStreaming = false;
+
+      if (FrameMode)
+      {
+        uint8_t payload[PULSE_HISTOGRAM_LEN * 4];
+        for (uint8_t i = 0; i < PULSE_HISTOGRAM_LEN; i++)
+        {
+          uint32_t count = PulseHistogram[i];
+          for (uint8_t j = 0; j < 4; j++, count >>= 8) {
+            payload[i * 4 + j] = (uint8_t)count;
+          }
+        }
+        SendFrame(FRAME_PULSE_INFO, payload, sizeof(payload));
+      }
+
+      EndOperation();
       break;
 
     case VOLTAGE:
-      Serial.print(MESSAGE_RESPONSE_FLAG);
-      Serial.print(MESSAGE_VOLTAGE_INFO);
-      Serial.println(GetVoltage(), 2);
+      if (FrameMode)
+      {
+        uint16_t voltage = GetVoltage() * 100;
+        uint8_t payload[2] = { lowByte(voltage), highByte(voltage) };
+        SendFrame(FRAME_VOLTAGE_INFO, payload, sizeof(payload));
+      }
+      else
+      {
+        Serial.print(MESSAGE_RESPONSE_FLAG);
+        Serial.print(MESSAGE_VOLTAGE_INFO);
+        Serial.println(GetVoltage(), 2);
+      }
       CommandMode = WAIT;
       break;
 
     case READ_BYTE:
-      CommandMode = WAIT;
-      break;
-
     case WRITE_BYTE:
-      CommandMode = WAIT;
-      break;
-
-    default:
-      if (!Serial.available()) {
+      if (ChipSelected == NONE)
+      {
+        if (FrameMode) {
+          SendError(ERROR_NO_CHIP, NULL, 0);
+        }
+        else
+        {
+          Serial.print(MESSAGE_RESPONSE_FLAG);
+          Serial.print(MESSAGE_ERROR);
+          Serial.println("No chip selected");
+        }
+        CommandMode = WAIT;
         break;
       }
 
-      uint8_t count = Serial.readBytes((char*)ReadingBuffer, BUF_LEN);
-
-      while (Serial.available()) {
-        Serial.read();
+      if (CommandMode == WRITE_BYTE && !CheckProgrammingVoltage())
+      {
+        CommandMode = WAIT;
+        break;
       }
 
-      if (count)
       {
-        String command((char*)ReadingBuffer);
-
-        int8_t commandFlagIndex = command.indexOf(MESSAGE_COMMAND_FLAG);
-        Serial.print(MESSAGE_RESPONSE_FLAG);
-        if (commandFlagIndex != -1)
+        // a frame carries a batch, RDBT and WRBT a single byte
+        uint8_t entryLength = AddressLength() + (CommandMode == READ_BYTE ? 0 : 1);
+        uint8_t count = FrameMode ? ReceivedLength / entryLength : 1;
+        uint8_t *values = BlockBuffer;
+        for (uint8_t i = 0; i < count; i++)
         {
-          if (command.indexOf(MESSAGE_SELECT_C16, commandFlagIndex + 4) != -1)
-          {
-            SelectChip(C16);
-            Serial.println(MESSAGE_OK);
-          }
-          else if (command.indexOf(MESSAGE_SELECT_C32, commandFlagIndex + 4) != -1)
-          {
-            SelectChip(C32);
-            Serial.println(MESSAGE_OK);
-          }
-          else if (command.indexOf(MESSAGE_SELECT_C64, commandFlagIndex + 4) != -1)
-          {
-            SelectChip(C64);
-            Serial.println(MESSAGE_OK);
-          }
-          else if (command.indexOf(MESSAGE_SELECT_C128, commandFlagIndex + 4) != -1)
-          {
-            SelectChip(C128);
-            Serial.println(MESSAGE_OK);
-          }
-          else if (command.indexOf(MESSAGE_SELECT_C256, commandFlagIndex + 4) != -1)
-          {
-            SelectChip(C256);
-            Serial.println(MESSAGE_OK);
-          }
-          else if (command.indexOf(MESSAGE_SELECT_C512, commandFlagIndex + 4) != -1)
-          {
-            SelectChip(C512);
-            Serial.println(MESSAGE_OK);
-          }
-          else if (command.indexOf(MESSAGE_VOLTAGE_INFO, commandFlagIndex + 4) != -1)
-          {
-            CommandMode = VOLTAGE;
-            Serial.println(MESSAGE_OK);
-          }
-          else if (command.indexOf(MESSAGE_READ_CHIP, commandFlagIndex + 4) != -1)
-          {
-            CommandMode = READ;
-            Serial.println(MESSAGE_OK);
-          }
-          else if (command.indexOf(MESSAGE_WRITE_CHIP, commandFlagIndex + 4) != -1)
+          uint8_t *entry = ReceivedPayload + i * entryLength;
+          uint32_t address = FrameMode ? GetAddress(entry) : ByteAddress;
+          uint8_t value = FrameMode ? entry[entryLength - 1] : ByteValue;
+          if (address > EndAddress)
           {
-            CommandMode = WRITE;
-            Serial.println(MESSAGE_OK);
+            if (FrameMode) {
+              SendError(ERROR_RANGE, NULL, 0);
+            }
+            else
+            {
+              Serial.print(MESSAGE_RESPONSE_FLAG);
+              Serial.print(MESSAGE_ERROR);
+              Serial.println("Address out of chip");
+            }
+            CommandMode = WAIT;
+            break;
           }
-          else if (command.indexOf(MESSAGE_READ_BYTE, commandFlagIndex + 4) != -1)
-          {
-            CommandMode = READ_BYTE;
-            Serial.println(MESSAGE_OK);
+
+          StartReading();
+          ReadChipBlock(address, &values[i], 1);
+          StopReading();
+          if (CommandMode == READ_BYTE || values[i] == value) {
+            continue;
           }
-          else if (command.indexOf(MESSAGE_WRITE_BYTE, commandFlagIndex + 4) != -1)
+
+          if ((values[i] & value) != value)
           {
-            CommandMode = WRITE_BYTE;
-            Serial.println(MESSAGE_OK);
+            ReportByteError(ERROR_NOT_ERASED, address, value, values[i]);
+            CommandMode = WAIT;
+            break;
           }
-          else if (command.indexOf(MESSAGE_SELECT_NONE, commandFlagIndex + 4) != -1)
+          uint8_t verify = ProgramChipByte(address, value);
+          if (verify != value)
           {
-            SelectChip(NONE);
-            Serial.println(MESSAGE_OK);
-          }
-          else {
-            Serial.println(MESSAGE_ERROR);
+            ReportByteError(ERROR_VERIFY, address, value, verify);
+            CommandMode = WAIT;
+            break;
           }
+          values[i] = verify;
         }
-        else {
-          Serial.println(MESSAGE_ERROR);
+
+        if (CommandMode == WAIT) {
+          break;
+        }
+
+        if (FrameMode) {
+          SendFrame(FRAME_BYTES, values, count);
+        }
+        else
+        {
+          Serial.print(MESSAGE_RESPONSE_FLAG);
+          Serial.print(CommandMode == READ_BYTE ? MESSAGE_READ_BYTE : MESSAGE_WRITE_BYTE);
+          PrintHexByte(values[0]);
+          Serial.println();
         }
       }
-  }
-}
 
-void WaitForData(void)
-{
-  unsigned long start = millis();
-  while (Serial.available() < 0)
-  {
-    if (millis() - start > 1000) {
+      CommandMode = WAIT;
       break;
-    }
-    WaitMillis(10);
-  }
-}
 
-void SelectChip(CHIP_TYPE newChip)
-{
-  ChipSelected = newChip;
-  digitalWrite(POWER_ENABLE_PIN, HIGH);
-  switch (newChip)
-  {
-    case C16:
-      digitalWrite(POWER_ENABLE_PIN, LOW);
-      EndAddress = 0x07ff;
-      break;
-    case C32:
-      digitalWrite(POWER_ENABLE_PIN, LOW);
-      EndAddress = 0x0fff;
-      break;
-    case C64:
-      EndAddress = 0x1fff;
-      break;
-    case C128:
-      EndAddress = 0x3fff;
+    case BLANK:
+      if (!OperationRunning)
+      {
+        if (ChipSelected == NONE)
+        {
+          SendError(ERROR_NO_CHIP, NULL, 0);
+          CommandMode = WAIT;
+          break;
+        }
+
+        StartReading();
+        RangeStart = StartAddress;
+        RangeEnd = EndAddress;
+        OperationAddress = StartAddress;
+        BlankFirst = 0;
+        BlankBytes = 0;
+        BlankBits = 0;
+        OperationRunning = true;
+        break;
+      }
+
+      if (OperationAddress < RangeEnd && !(BlankBytes && BlankEarlyExit))
+      {
+        uint8_t buffer[FRAME_BLOCK_LEN];
+        ReadChipBlock(OperationAddress, buffer, FRAME_BLOCK_LEN);
+        for (uint8_t j = 0; j < FRAME_BLOCK_LEN; j++)
+        {
+          if (buffer[j] == 0xFF) {
+            continue;
+          }
+
+          if (!BlankBytes) {
+            BlankFirst = OperationAddress + j;
+          }
+          BlankBytes++;
+          for (uint8_t bits = ~buffer[j]; bits; bits &= bits - 1) {
+            BlankBits++;
+          }
+        }
+        OperationAddress += FRAME_BLOCK_LEN;
+        break;
+      }
+
+      {
+        uint8_t payload[13] = { BlankBytes == 0 };
+        uint8_t length = 1 + PutAddress(payload + 1, BlankFirst);
+        for (uint8_t j = 0; j < 4; j++)
+        {
+          payload[length + j] = (uint8_t)(BlankBytes >> (j * 8));
+          payload[length + 4 + j] = (uint8_t)(BlankBits >> (j * 8));
+        }
+        SendFrame(FRAME_BLANK_INFO, payload, length + 8);
+      }
+
+      StopReading();
+
+      EndOperation();
       break;
-    case C256:
-      EndAddress = 0x7fff;
+
+    case CRC:
+      if (!OperationRunning)
+      {
+        if (ChipSelected == NONE)
+        {
+          SendError(ERROR_NO_CHIP, NULL, 0);
+          CommandMode = WAIT;
+          break;
+        }
+
+        StartReading();
+        RangeStart = StartAddress;
+        RangeEnd = EndAddress;
+        OperationAddress = StartAddress;
+        OperationCrc = 0xFFFFFFFF;
+        CrcTableLength = 0;
+        OperationRunning = true;
+        break;
+      }
+
+      if (OperationAddress < RangeEnd)
+      {
+        uint8_t buffer[FRAME_BLOCK_LEN];
+        uint32_t i = OperationAddress;
+        ReadChipBlock(i, buffer, FRAME_BLOCK_LEN);
+        for (uint8_t j = 0; j < FRAME_BLOCK_LEN; j++) {
+          OperationCrc = Crc32Update(OperationCrc, buffer[j]);
+        }
+        OperationAddress += FRAME_BLOCK_LEN;
+
+        // block boundary, or the chip is smaller than one block
+        uint16_t blockMask = (1 << CrcBlockShift) - 1;
+        if (((i + FRAME_BLOCK_LEN) & blockMask) && i + FRAME_BLOCK_LEN <= RangeEnd) {
+          break;
+        }
+
+        uint32_t crc = ~OperationCrc;
+        for (uint8_t j = 0; j < 4; j++, crc >>= 8) {
+          BlockBuffer[CrcTableLength++] = (uint8_t)crc;
+        }
+        OperationCrc = 0xFFFFFFFF;
+
+        if (CrcTableLength == sizeof(BlockBuffer))
+        {
+          SendFrame(FRAME_CRC_TABLE, BlockBuffer, CrcTableLength);
+          CrcTableLength = 0;
+        }
+        break;
+      }
+
+      if (CrcTableLength) {
+        SendFrame(FRAME_CRC_TABLE, BlockBuffer, CrcTableLength);
+      }
+
+      StopReading();
+
+      SendFrame(FRAME_OK, NULL, 0);
+      EndOperation();
       break;
-    case C512:
-      EndAddress = 0xffff;
+
+    case BAUD:
+      // OK for the BAUD command still goes out at the old rate
+      Serial.flush();
+      Serial.end();
+      Serial.begin(NewBaudRate);
+
+      if (WaitForBaudTest()) {
+        BaudRate = NewBaudRate;
+      }
+      else
+      {
+        Serial.end();
+        Serial.begin(BaudRate);
+      }
+
+      CommandMode = WAIT;
       break;
+
     default:
-      ChipSelected = NONE;
-      EndAddress = 0x0000;
+      if (!Serial.available()) {
+        break;
+      }
+
+      if (Serial.peek() == FRAME_SYNC)
+      {
+        FrameMode = true;
+        if (ReadFrame()) {
+          HandleFrame();
+        }
+        else
+        {
+          while (Serial.available()) {
+            Serial.read();
+          }
+          SendError(ERROR_CRC, NULL, 0);
+        }
+        break;
+      }
+
+      FrameMode = false;
+      uint8_t count = Serial.readBytes((char*)ReadingBuffer, BUF_LEN);
+
+      while (Serial.available()) {
+        Serial.read();
+      }
+
+      if (count)
+      {
+        ReadingBuffer[count] = 0;
+        String command((char*)ReadingBuffer);
+
+        // the tag has to follow the flag directly, a C128 or C512 in the
+        // hex arguments of RDBT/WRBT is not a chip select
+        int8_t commandFlagIndex = command.indexOf(MESSAGE_COMMAND_FLAG);
+        Serial.print(MESSAGE_RESPONSE_FLAG);
+        if (commandFlagIndex != -1)
+        {
+          if (command.startsWith(MESSAGE_SELECT_C16, commandFlagIndex + 4))
+          {
+            SelectChip(C16);
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_SELECT_C32, commandFlagIndex + 4))
+          {
+            SelectChip(C32);
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_SELECT_C64, commandFlagIndex + 4))
+          {
+            SelectChip(C64);
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_SELECT_C128, commandFlagIndex + 4))
+          {
+            SelectChip(C128);
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_SELECT_C256, commandFlagIndex + 4))
+          {
+            SelectChip(C256);
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_SELECT_C512, commandFlagIndex + 4))
+          {
+            SelectChip(C512);
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_VOLTAGE_INFO, commandFlagIndex + 4))
+          {
+            CommandMode = VOLTAGE;
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_READ_CHIP, commandFlagIndex + 4))
+          {
+            RangeStart = StartAddress;
+            RangeEnd = EndAddress;
+            CommandMode = READ;
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_WRITE_CHIP, commandFlagIndex + 4))
+          {
+            RangeStart = StartAddress;
+            RangeEnd = EndAddress;
+            CommandMode = WRITE;
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_READ_BYTE, commandFlagIndex + 4))
+          {
+            // RDBT + 4 hex digits of address, padded to 16 bytes
+            ByteAddress = strtoul(command.substring(commandFlagIndex + 8, commandFlagIndex + 12).c_str(), NULL, 16);
+            CommandMode = READ_BYTE;
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_WRITE_BYTE, commandFlagIndex + 4))
+          {
+            // WRBT + 4 hex digits of address + 2 of value, padded to 16 bytes
+            ByteAddress = strtoul(command.substring(commandFlagIndex + 8, commandFlagIndex + 12).c_str(), NULL, 16);
+            ByteValue = strtoul(command.substring(commandFlagIndex + 12, commandFlagIndex + 14).c_str(), NULL, 16);
+            CommandMode = WRITE_BYTE;
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_ABORT, commandFlagIndex + 4))
+          {
+            // nothing running, the operation ended before the ABORT came in
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_SELECT_NONE, commandFlagIndex + 4))
+          {
+            SelectChip(NONE);
+            Serial.println(MESSAGE_OK);
+          }
+          else if (command.startsWith(MESSAGE_BAUD_RATE, commandFlagIndex + 4))
+          {
+            NewBaudRate = command.substring(commandFlagIndex + 8).toInt();
+            if (IsBaudRateSupported(NewBaudRate))
+            {
+              CommandMode = BAUD;
+              Serial.println(MESSAGE_OK);
+            }
+            else {
+              Serial.println(MESSAGE_ERROR);
+            }
+          }
+          else {
+            Serial.println(MESSAGE_ERROR);
+          }
+        }
+        else {
+          Serial.println(MESSAGE_ERROR);
+        }
+      }
   }
 }
 
-
-void SetProgrammingVoltage(bool enable)
+void WaitForData(void)
 {
-  switch (ChipSelected)
+  unsigned long start = millis();
+  while (Serial.available() < 0)
   {
-    case C16:
-      digitalWrite(PROGRAMMING_VOLTAGE_ENABLE_C16_PIN, enable);
-      break;
-    case C32:
-    case C512:
-      digitalWrite(PROGRAMMING_VOLTAGE_ENABLE_C32_PIN, enable);
+    if (millis() - start > 1000) {
       break;
-    case C64:
-    case C128:
-    case C256:
+    }
+    WaitMillis(10);
+  }
+}
+
+bool IsBaudRateSupported(unsigned long baudRate)
+{
+  switch (baudRate)
+  {
+    case 115200:
+    case 250000:
+    case 500000:
+    case 1000000:
+    case 2000000:
+      return true;
     default:
-      digitalWrite(PROGRAMMING_VOLTAGE_ENABLE_OTHER_PIN, enable);
+      return false;
+  }
+}
+
+// The host confirms the new rate with "!@#$BTST" and the test pattern,
+// the pattern is echoed back; anything else falls back to the old rate
+bool WaitForBaudTest(void)
+{
+  Serial.setTimeout(BAUD_TEST_TIMEOUT);
+  uint8_t count = Serial.readBytes((char*)ReadingBuffer, BUF_LEN);
+
+  if (count != 8 + BAUD_TEST_LEN
+      || memcmp(ReadingBuffer, MESSAGE_COMMAND_FLAG MESSAGE_BAUD_TEST, 8)
+      || memcmp(ReadingBuffer + 8, BaudTestPattern, BAUD_TEST_LEN)) {
+    return false;
+  }
+
+  Serial.print(MESSAGE_RESPONSE_FLAG);
+  Serial.print(MESSAGE_BAUD_TEST);
+  Serial.write(BaudTestPattern, BAUD_TEST_LEN);
+  Serial.println();
+  return true;
+}
+
+uint16_t Crc16Update(uint16_t crc, uint8_t data)
+{
+#if defined(__AVR__)
+  return _crc_xmodem_update(crc, data);
+#else
+  crc ^= (uint16_t)data << 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  }
+  return crc;
+#endif
+}
+
+// CRC-32 of the verify table, one nibble per Crc32Table lookup
+uint32_t Crc32Update(uint32_t crc, uint8_t data)
+{
+  crc = pgm_read_dword(&Crc32Table[(crc ^ data) & 0x0F]) ^ (crc >> 4);
+  return pgm_read_dword(&Crc32Table[(crc ^ (data >> 4)) & 0x0F]) ^ (crc >> 4);
+}
+
+// Reads one frame into ReceivedOpcode/ReceivedLength/ReceivedPayload,
+// false on timeout, oversized payload or CRC mismatch
+bool ReadFrame(void)
+{
+  uint8_t header[FRAME_HEADER_LEN];
+  if (Serial.readBytes((char*)header, FRAME_HEADER_LEN) != FRAME_HEADER_LEN
+      || header[0] != FRAME_SYNC || header[3] > FRAME_MAX_PAYLOAD) {
+    return false;
+  }
+
+  uint8_t crcBytes[FRAME_CRC_LEN];
+  if (Serial.readBytes((char*)ReceivedPayload, header[3]) != header[3]
+      || Serial.readBytes((char*)crcBytes, FRAME_CRC_LEN) != FRAME_CRC_LEN) {
+    return false;
+  }
+
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 1; i < FRAME_HEADER_LEN; i++) {
+    crc = Crc16Update(crc, header[i]);
+  }
+  for (uint8_t i = 0; i < header[3]; i++) {
+    crc = Crc16Update(crc, ReceivedPayload[i]);
+  }
+  if (crc != (crcBytes[0] | (crcBytes[1] << 8))) {
+    return false;
+  }
+
+  ReceivedOpcode = header[1];
+  ReceivedLength = header[3];
+  return true;
+}
+
+// Non-blocking receiver for streamed writes, collects one frame in StreamFrame
+void PollFrame(void)
+{
+  while (!StreamReady && Serial.available())
+  {
+    uint8_t data = Serial.read();
+    if (StreamLength == 0 && data != FRAME_SYNC) {
+      continue;
+    }
+
+    StreamFrame[StreamLength++] = data;
+    if (StreamLength == FRAME_HEADER_LEN && StreamFrame[3] > FRAME_MAX_PAYLOAD)
+    {
+      StreamLength = 0;
+      continue;
+    }
+    if (StreamLength >= FRAME_HEADER_LEN && StreamLength == FRAME_HEADER_LEN + StreamFrame[3] + FRAME_CRC_LEN) {
+      StreamReady = true;
+    }
+  }
+}
+
+// Moves a streamed frame into ReceivedPayload so the next one can come in
+bool TakeStreamFrame(void)
+{
+  if (!StreamReady) {
+    return false;
+  }
+
+  uint8_t length = StreamFrame[3];
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 1; i < FRAME_HEADER_LEN + length; i++) {
+    crc = Crc16Update(crc, StreamFrame[i]);
+  }
+  bool valid = crc == (StreamFrame[FRAME_HEADER_LEN + length] | (StreamFrame[FRAME_HEADER_LEN + length + 1] << 8));
+  if (valid)
+  {
+    ReceivedOpcode = StreamFrame[1];
+    ReceivedLength = length;
+    memcpy(ReceivedPayload, StreamFrame + FRAME_HEADER_LEN, length);
+  }
+
+  StreamLength = 0;
+  StreamReady = false;
+  return valid;
+}
+
+void DrainSerial(void)
+{
+  unsigned long last = millis();
+  while (millis() - last < 20)
+  {
+    if (Serial.available())
+    {
+      Serial.read();
+      last = millis();
+    }
   }
 }
 
-void SetWriteMode(void)
+void SendFrame(uint8_t opcode, const uint8_t *payload, uint8_t length)
 {
-  pinMode(DATA_B0_PIN, OUTPUT);
-  pinMode(DATA_B1_PIN, OUTPUT);
-  pinMode(DATA_B2_PIN, OUTPUT);
-  pinMode(DATA_B3_PIN, OUTPUT);
-  pinMode(DATA_B4_PIN, OUTPUT);
-  pinMode(DATA_B5_PIN, OUTPUT);
-  pinMode(DATA_B6_PIN, OUTPUT);
-  pinMode(DATA_B7_PIN, OUTPUT);
+  uint8_t header[FRAME_HEADER_LEN] = { FRAME_SYNC, opcode, FrameSequence++, length };
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 1; i < FRAME_HEADER_LEN; i++) {
+    crc = Crc16Update(crc, header[i]);
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    crc = Crc16Update(crc, payload[i]);
+  }
+
+  Serial.write(header, FRAME_HEADER_LEN);
+  if (length) {
+    Serial.write(payload, length);
+  }
+  Serial.write(lowByte(crc));
+  Serial.write(highByte(crc));
 }
 
-void SetReadMode(void)
+void SendError(uint8_t code, const uint8_t *arguments, uint8_t length)
 {
-  pinMode(DATA_B0_PIN, INPUT_PULLUP);
-  pinMode(DATA_B1_PIN, INPUT_PULLUP);
-  pinMode(DATA_B2_PIN, INPUT_PULLUP);
-  pinMode(DATA_B3_PIN, INPUT_PULLUP);
-  pinMode(DATA_B4_PIN, INPUT_PULLUP);
-  pinMode(DATA_B5_PIN, INPUT_PULLUP);
-  pinMode(DATA_B6_PIN, INPUT_PULLUP);
-  pinMode(DATA_B7_PIN, INPUT_PULLUP);
+  uint8_t payload[8] = { code };
+  if (length) {
+    memcpy(payload + 1, arguments, length);
+  }
+  SendFrame(FRAME_ERROR, payload, length + 1);
 }
 
-uint16_t GenerateAddress(uint16_t address)
+void HandleFrame(void)
 {
-  byte high = highByte(address);
-  byte low = lowByte(address);
-  switch (ChipSelected)
+  switch (ReceivedOpcode)
   {
-    case C16:
+    case FRAME_HELLO:
+      {
+        // new session, options go back to defaults
+        Options = 0;
+        BlockLength = FRAME_BLOCK_LEN;
+        uint8_t payload[4] = { PROTOCOL_VERSION, BlockLength, CAPABILITIES, FRAME_MAX_BLOCK_LEN };
+        SendFrame(FRAME_INFO, payload, sizeof(payload));
+      }
       break;
-    //      if(CommandMode == READ) {
-    //        high |= 1 << 3; // A11 (C32+) is Vpp for C16 (5v for read)
-    //      }
-    //      break;
-    case C64:
-    case C128:
-      if (CommandMode == READ) {
-        high |= 1 << 6; // A14 (C256 and C512) is ~PGM for C64 and C128
+    case FRAME_OPTIONS:
+      if (ReceivedLength < 1 || ReceivedLength > 2 || (ReceivedPayload[0] & ~CAPABILITIES))
+      {
+        SendError(ERROR_UNKNOWN_COMMAND, NULL, 0);
+        break;
+      }
+      if (ReceivedLength == 2)
+      {
+        uint8_t length = ReceivedPayload[1];
+        if (length < FRAME_MIN_BLOCK_LEN || length > FRAME_MAX_BLOCK_LEN || (length & (length - 1)))
+        {
+          SendError(ERROR_UNKNOWN_COMMAND, NULL, 0);
+          break;
+        }
+        BlockLength = length;
       }
+      Options = ReceivedPayload[0];
+      // a 1 to 8 Mbit part can't be addressed any more
+      if (ChipSelected > C512 && !(Options & CAPABILITY_WIDE_ADDRESS)) {
+        SelectChip(NONE);
+      }
+      SendFrame(FRAME_OK, NULL, 0);
       break;
-    case C32:
-    case C256:
-    case C512:
-    default:
+    case FRAME_SELECT:
+      if (ReceivedLength != 1 || ReceivedPayload[0] > C080)
+      {
+        SendError(ERROR_UNKNOWN_COMMAND, NULL, 0);
+        break;
+      }
+      if (ReceivedPayload[0] > C512 && !(Options & CAPABILITY_WIDE_ADDRESS))
+      {
+        SendError(ERROR_RANGE, NULL, 0);
+        break;
+      }
+      SelectChip((CHIP_TYPE)ReceivedPayload[0]);
+      SendFrame(FRAME_OK, NULL, 0);
+      break;
+    case FRAME_VOLTAGE:
+      CommandMode = VOLTAGE;
+      break;
+    case FRAME_READ:
+      if (SetRange()) {
+        CommandMode = READ;
+      }
+      break;
+    case FRAME_WRITE:
+      if (SetRange()) {
+        CommandMode = WRITE;
+      }
       break;
+    case FRAME_BLANK:
+      BlankEarlyExit = ReceivedLength && ReceivedPayload[0];
+      CommandMode = BLANK;
+      break;
+    case FRAME_READ_BYTES:
+    case FRAME_WRITE_BYTES:
+      {
+        uint8_t entryLength = AddressLength() + (ReceivedOpcode == FRAME_READ_BYTES ? 0 : 1);
+        if (!ReceivedLength || ReceivedLength % entryLength)
+        {
+          SendError(ERROR_UNKNOWN_COMMAND, NULL, 0);
+          break;
+        }
+        CommandMode = ReceivedOpcode == FRAME_READ_BYTES ? READ_BYTE : WRITE_BYTE;
+      }
+      break;
+    case FRAME_CRC:
+      if (ReceivedLength != 1 || ReceivedPayload[0] < CRC_MIN_SHIFT || ReceivedPayload[0] > CRC_MAX_SHIFT)
+      {
+        SendError(ERROR_UNKNOWN_COMMAND, NULL, 0);
+        break;
+      }
+      CrcBlockShift = ReceivedPayload[0];
+      CommandMode = CRC;
+      break;
+    case FRAME_ABORT:
+      // nothing running, an answer would be taken for the next command's
+      break;
+    case FRAME_STATUS:
+      SendStatus();
+      break;
+    case FRAME_TIMING:
+      if (ReceivedLength != 5 || !(ReceivedPayload[0] | ReceivedPayload[1]) || !ReceivedPayload[2] || ReceivedPayload[4] > VPP_OTHER)
+      {
+        SendError(ERROR_UNKNOWN_COMMAND, NULL, 0);
+        break;
+      }
+      if (ChipSelected == NONE)
+      {
+        SendError(ERROR_NO_CHIP, NULL, 0);
+        break;
+      }
+      PulseWidth = ReceivedPayload[0] | (ReceivedPayload[1] << 8);
+      MaxPulses = ReceivedPayload[2];
+      OverprogramFactor = ReceivedPayload[3];
+      VppPin = VppLinePins[ReceivedPayload[4]];
+      SendFrame(FRAME_OK, NULL, 0);
+      break;
+    default:
+      SendError(ERROR_UNKNOWN_COMMAND, NULL, 0);
+  }
+}
+
+// ABORT and STATUS while an operation runs, in the format it was started
+// with; an ASCII operation only takes ABRT, padded to 16 bytes
+void PollCommand(void)
+{
+  if (!Serial.available()) {
+    return;
+  }
+
+  if (!FrameMode)
+  {
+    uint8_t count = Serial.readBytes((char*)ReadingBuffer, BUF_LEN);
+    ReadingBuffer[count] = 0;
+    if (strstr((char*)ReadingBuffer, MESSAGE_COMMAND_FLAG MESSAGE_ABORT)) {
+      AbortOperation();
+    }
+    return;
+  }
+
+  if (Serial.peek() != FRAME_SYNC)
+  {
+    Serial.read();
+    return;
+  }
+
+  if (!ReadFrame()) {
+    SendError(ERROR_CRC, NULL, 0);
+  }
+  else if (ReceivedOpcode == FRAME_ABORT) {
+    AbortOperation();
+  }
+  else if (ReceivedOpcode == FRAME_STATUS) {
+    SendStatus();
+  }
+  else {
+    SendError(ERROR_BUSY, NULL, 0);
   }
-  return (high << 8) | low;
 }
 
-void SetAddress(uint16_t address)
+void SendStatus(void)
 {
-  address = GenerateAddress(address);
-  digitalWrite(SHIFT_LATCH_PIN, LOW);
-  byte registerTwo = highByte(address);
-  byte registerOne = lowByte(address);
-  shiftOut(SHIFT_DATA_PIN, SHIFT_CLOCK_PIN, MSBFIRST, registerTwo);
-  shiftOut(SHIFT_DATA_PIN, SHIFT_CLOCK_PIN, MSBFIRST, registerOne);
-  digitalWrite(SHIFT_LATCH_PIN, HIGH);
+  uint8_t payload[9] = { (uint8_t)(OperationRunning ? CommandMode : WAIT) };
+  uint8_t length = 1 + PutAddress(payload + 1, OperationRunning ? OperationAddress : 0);
+  length += PutAddress(payload + length, OperationRunning ? RangeEnd : 0);
+  SendFrame(FRAME_STATUS_INFO, payload, length);
 }
 
-uint8_t GetData(void)
+// Stops between two blocks or two programmed bytes, Vpp is only on during a
+// pulse but all enables are driven low again and the bus released anyway
+void AbortOperation(void)
 {
-  uint8_t data = 0;
-  data |= digitalRead(DATA_B0_PIN) << 0;
-  data |= digitalRead(DATA_B1_PIN) << 1;
-  data |= digitalRead(DATA_B2_PIN) << 2;
-  data |= digitalRead(DATA_B3_PIN) << 3;
-  data |= digitalRead(DATA_B4_PIN) << 4;
-  data |= digitalRead(DATA_B5_PIN) << 5;
-  data |= digitalRead(DATA_B6_PIN) << 6;
-  data |= digitalRead(DATA_B7_PIN) << 7;
-  return data;
+  digitalWrite(PROGRAMMING_VOLTAGE_ENABLE_C16_PIN, LOW);
+  digitalWrite(PROGRAMMING_VOLTAGE_ENABLE_C32_PIN, LOW);
+  digitalWrite(PROGRAMMING_VOLTAGE_ENABLE_OTHER_PIN, LOW);
+  StopReading();
+  SetReadMode();
+
+  // a half encoded read must not leak into the next one
+  RleOutputLength = 0;
+  RleLiteralCount = 0;
+  RleRunCount = 0;
+
+  if (FrameMode)
+  {
+    uint8_t arguments[4];
+    SendError(ERROR_ABORTED, arguments, PutAddress(arguments, OperationAddress));
+  }
+  else
+  {
+    Serial.print(MESSAGE_RESPONSE_FLAG);
+    Serial.print(MESSAGE_ERROR);
+    Serial.println("Aborted");
+  }
+  EndOperation();
 }
 
-void SetData(uint8_t data)
+void EndOperation(void)
 {
-  digitalWrite(DATA_B0_PIN, (data & (1 << 0)));
-  digitalWrite(DATA_B1_PIN, (data & (1 << 1)));
-  digitalWrite(DATA_B2_PIN, (data & (1 << 2)));
-  digitalWrite(DATA_B3_PIN, (data & (1 << 3)));
-  digitalWrite(DATA_B4_PIN, (data & (1 << 4)));
-  digitalWrite(DATA_B5_PIN, (data & (1 << 5)));
-  digitalWrite(DATA_B6_PIN, (data & (1 << 6)));
-  digitalWrite(DATA_B7_PIN, (data & (1 << 7)));
+  // blocks the host already sent ahead must not be taken as commands
+  if (WriteStreaming)
+  {
+    DrainSerial();
+    WriteStreaming = false;
+  }
+  OperationRunning = false;
+  CommandMode = WAIT;
 }
 
-uint8_t ReadByte(uint16_t address)
+// Optional first and last address of a READ or WRITE frame, whole chip without
+bool SetRange(void)
 {
-  SetAddress(address);
-  return GetData();
+  RangeStart = StartAddress;
+  RangeEnd = EndAddress;
+  uint8_t length = AddressLength();
+  if (ReceivedLength == length * 2)
+  {
+    RangeStart = GetAddress(ReceivedPayload);
+    RangeEnd = GetAddress(ReceivedPayload + length);
+  }
+  if ((ReceivedLength != 0 && ReceivedLength != length * 2) || RangeStart > RangeEnd || RangeEnd > EndAddress)
+  {
+    SendError(ERROR_RANGE, NULL, 0);
+    return false;
+  }
+  return true;
+}
+
+uint8_t AddressLength(void)
+{
+  return (Options & CAPABILITY_WIDE_ADDRESS) ? 4 : 2;
+}
+
+// Writes an address in the negotiated width, LSB first, returns its length
+uint8_t PutAddress(uint8_t *buffer, uint32_t address)
+{
+  uint8_t length = AddressLength();
+  for (uint8_t i = 0; i < length; i++, address >>= 8) {
+    buffer[i] = (uint8_t)address;
+  }
+  return length;
+}
+
+uint32_t GetAddress(const uint8_t *buffer)
+{
+  uint32_t address = 0;
+  for (uint8_t i = AddressLength(); i > 0; i--) {
+    address = (address << 8) | buffer[i - 1];
+  }
+  return address;
+}
+
+// Streaming run-length encoder for reads, tokens are packed into RleOutput
+// and a FRAME_DATA_RLE frame goes out whenever the next token would not fit
+void RleEncodeByte(uint8_t data)
+{
+  if (RleRunCount && data == RleRunByte && RleRunCount < RLE_MAX_RUN)
+  {
+    RleRunCount++;
+    return;
+  }
+
+  RleEndRun();
+  RleRunByte = data;
+  RleRunCount = 1;
+}
+
+void RleEndRun(void)
+{
+  if (RleRunCount >= RLE_MIN_RUN)
+  {
+    RleEmitLiterals();
+    RleReserve(2);
+    RleOutput[RleOutputLength++] = 0x80 | (RleRunCount - 1);
+    RleOutput[RleOutputLength++] = RleRunByte;
+  }
+  else
+  {
+    // short runs are cheaper as literals
+    for (uint8_t i = 0; i < RleRunCount; i++)
+    {
+      RleLiterals[RleLiteralCount++] = RleRunByte;
+      if (RleLiteralCount == RLE_MAX_LITERAL) {
+        RleEmitLiterals();
+      }
+    }
+  }
+  RleRunCount = 0;
+}
+
+void RleEmitLiterals(void)
+{
+  if (!RleLiteralCount) {
+    return;
+  }
+
+  RleReserve(RleLiteralCount + 1);
+  RleOutput[RleOutputLength++] = RleLiteralCount - 1;
+  memcpy(RleOutput + RleOutputLength, RleLiterals, RleLiteralCount);
+  RleOutputLength += RleLiteralCount;
+  RleLiteralCount = 0;
+}
+
+void RleReserve(uint8_t length)
+{
+  if (RleOutputLength + length > FRAME_MAX_PAYLOAD)
+  {
+    SendFrame(FRAME_DATA_RLE, RleOutput, RleOutputLength);
+    RleOutputLength = 0;
+  }
+}
+
+void RleFlush(void)
+{
+  RleEndRun();
+  RleEmitLiterals();
+  if (RleOutputLength) {
+    SendFrame(FRAME_DATA_RLE, RleOutput, RleOutputLength);
+  }
+  RleOutputLength = 0;
+}
+
+// Returns the decoded length, -1 on a truncated token or output overflow
+int16_t RleDecode(const uint8_t *input, uint8_t length, uint8_t *output, uint8_t capacity)
+{
+  uint8_t in = 0;
+  uint16_t out = 0;
+  while (in < length)
+  {
+    uint8_t token = input[in++];
+    uint8_t count = (token & 0x7F) + 1;
+    if (out + count > capacity) {
+      return -1;
+    }
+
+    if (token & 0x80)
+    {
+      if (in >= length) {
+        return -1;
+      }
+      memset(output + out, input[in++], count);
+    }
+    else
+    {
+      if (in + count > length) {
+        return -1;
+      }
+      memcpy(output + out, input + in, count);
+      in += count;
+    }
+    out += count;
+  }
+  return out;
+}
+
+void StartReading(void)
+{
+  SetReadMode();
+
+  if (ChipSelected == C16) {
+    digitalWrite(READ_VOLTAGE_ENABLE_PIN, LOW);
+  }
+  digitalWrite(CHIP_ENABLE_PIN, LOW);
+  digitalWrite(OUTPUT_ENABLE_PIN, LOW);
+}
+
+void StopReading(void)
+{
+  digitalWrite(OUTPUT_ENABLE_PIN, HIGH);
+  digitalWrite(CHIP_ENABLE_PIN, HIGH);
+
+  if (ChipSelected == C16) {
+    digitalWrite(READ_VOLTAGE_ENABLE_PIN, HIGH);
+  }
+}
+
+bool CheckProgrammingVoltage(void)
+{
+  programmingVoltage = GetVoltage();
+  if (programmingVoltage > 6.0) {
+    return true;
+  }
+
+  if (FrameMode)
+  {
+    uint16_t voltage = programmingVoltage * 100;
+    uint8_t arguments[2] = { lowByte(voltage), highByte(voltage) };
+    SendError(ERROR_LOW_VOLTAGE, arguments, sizeof(arguments));
+  }
+  else
+  {
+    Serial.print(MESSAGE_RESPONSE_FLAG);
+    Serial.print(MESSAGE_ERROR);
+    Serial.print("Low programming voltage (");
+    Serial.print(programmingVoltage, 2);
+    Serial.println("V)");
+  }
+  return false;
+}
+
+// ERROR_NOT_ERASED or ERROR_VERIFY in the format of the current command
+void ReportByteError(uint8_t code, uint32_t address, uint8_t wrote, uint8_t read)
+{
+  if (FrameMode)
+  {
+    uint8_t arguments[6];
+    uint8_t length = PutAddress(arguments, address);
+    arguments[length++] = wrote;
+    arguments[length++] = read;
+    SendError(code, arguments, length);
+    return;
+  }
+
+  Serial.print(MESSAGE_RESPONSE_FLAG);
+  Serial.print(MESSAGE_ERROR);
+  if (code == ERROR_NOT_ERASED)
+  {
+    Serial.print("Can't write 0x");
+    Serial.print(wrote, HEX);
+    Serial.print(" over 0x");
+  }
+  else
+  {
+    Serial.print("Wrote 0x");
+    Serial.print(wrote, HEX);
+    Serial.print(", read 0x");
+  }
+  Serial.print(read, HEX);
+  Serial.print(", address 0x");
+  Serial.println(address, HEX);
 }
 
-void WriteByte(uint16_t address, uint8_t data)
+void PrintHexByte(uint8_t value)
+{
+  if (value < 0x10) {
+    Serial.print('0');
+  }
+  Serial.print(value, HEX);
+}
+
+void SelectChip(CHIP_TYPE newChip)
+{
+  if (newChip > C080 || (newChip > C512 && ADDRESS_SHIFT_STAGES < 3)) {
+    newChip = NONE;
+  }
+
+  ChipEntry entry;
+  memcpy_P(&entry, &ChipTable[newChip], sizeof(entry));
+  ChipSelected = newChip;
+  digitalWrite(POWER_ENABLE_PIN, entry.lowPower ? LOW : HIGH);
+  EndAddress = entry.endAddress;
+  ReadChipBlock = entry.readBlock;
+  ProgramChipByte = entry.programByte;
+  PulseWidth = entry.pulseWidth;
+  MaxPulses = entry.maxPulses;
+  OverprogramFactor = entry.overprogramFactor;
+  VppPin = VppLinePins[entry.vppLine];
+}
+
+template <CHIP_TYPE chip>
+void ReadBlock(uint32_t address, uint8_t *buffer, uint8_t length)
+{
+  for (uint8_t j = 0; j < length; j++)
+  {
+    SetAddress((address + j) | ReadAddressMask(chip));
+    buffer[j] = GetData();
+  }
+}
+
+template <CHIP_TYPE chip>
+uint8_t ProgramByte(uint32_t address, uint8_t data)
 {
   SetAddress(address);
+
+  uint8_t pulses = 0;
+  uint8_t verify;
+  do
+  {
+    ProgramPulse<chip>(data, PulseWidth);
+    pulses++;
+    verify = VerifyData<chip>();
+  } while (verify != data && pulses < MaxPulses);
+
+  if (verify != data)
+  {
+    // Vpp may still be settling, give the last read another chance
+    WaitMicros(1000);
+    return VerifyData<chip>();
+  }
+
+  if (OverprogramFactor) {
+    ProgramPulse<chip>(data, (uint32_t)PulseWidth * OverprogramFactor * pulses);
+  }
+
+  PulseHistogram[pulses < PULSE_HISTOGRAM_LEN ? pulses - 1 : PULSE_HISTOGRAM_LEN - 1]++;
+  return verify;
+}
+
+template <CHIP_TYPE chip>
+void ProgramPulse(uint8_t data, uint32_t width)
+{
+  SetWriteMode();
+  digitalWrite(VppPin, HIGH);
   SetData(data);
-  switch (ChipSelected)
+  if (chip == C16)
   {
-    case C16:
-      digitalWrite(CHIP_ENABLE_PIN, HIGH);
-      WaitMillis(15);
-      digitalWrite(CHIP_ENABLE_PIN, LOW);
-      break;
-    case C32:
-    case C64:
-    case C128:
-    case C256:
-    case C512:
-    default:
-      digitalWrite(CHIP_ENABLE_PIN, LOW);
-      delayMicroseconds(110);
-      digitalWrite(CHIP_ENABLE_PIN, HIGH);
-      break;
+    digitalWrite(CHIP_ENABLE_PIN, HIGH);
+    WaitMicros(width);
+    digitalWrite(CHIP_ENABLE_PIN, LOW);
   }
+  else
+  {
+    digitalWrite(CHIP_ENABLE_PIN, LOW);
+    WaitMicros(width);
+    digitalWrite(CHIP_ENABLE_PIN, HIGH);
+  }
+  digitalWrite(VppPin, LOW);
 }
 
 double GetVoltage(void)
@@ -546,10 +1773,11 @@ double GetVoltage(void)
   return (programmingVoltage * (RESISTOR_TOP_VALUE + RESISTOR_BOTTOM_VALUE));
 }
 
+template <CHIP_TYPE chip>
 uint8_t VerifyData(void)
 {
   SetReadMode();
-  if (ChipSelected == C16) {
+  if (chip == C16) {
     digitalWrite(READ_VOLTAGE_ENABLE_PIN, LOW);
   }
 
@@ -560,7 +1788,7 @@ uint8_t VerifyData(void)
   digitalWrite(OUTPUT_ENABLE_PIN, HIGH);
   digitalWrite(CHIP_ENABLE_PIN, HIGH);
 
-  if (ChipSelected == C16) {
+  if (chip == C16) {
     digitalWrite(READ_VOLTAGE_ENABLE_PIN, HIGH);
   }
 
@@ -576,3 +1804,19 @@ void WaitMillis(unsigned long period)
     delayMicroseconds(1000); 
   }
 }
+
+void WaitMicros(uint32_t period)
+{
+  // delayMicroseconds is only accurate up to 16383 us, a streamed write
+  // also has to empty the 64 bytes serial buffer in between
+  uint16_t step = WriteStreaming ? 200 : 16000;
+  while (period > step)
+  {
+    delayMicroseconds(step);
+    period -= step;
+    if (WriteStreaming) {
+      PollFrame();
+    }
+  }
+  delayMicroseconds(period);
+}